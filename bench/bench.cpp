@@ -0,0 +1,383 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/* Throughput of the buffer growth and JSON decode paths. Not run by
+   `make check`; build with `make bench/bench`, and use an optimized build
+   (i.e. `CXXFLAGS="-O2 -DNDEBUG"`) for meaningful numbers. */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <rapidjson/reader.h>
+#include <rapidjson/memorystream.h>
+
+#include "arena.hpp"
+#include "byte_rope.hpp"
+#include "byte_slice.hpp"
+#include "byte_stream.hpp"
+#include "method.hpp"
+#include "pub.hpp"
+#include "rpc/json.hpp"
+#include "span.hpp"
+#include "wire/field.hpp"
+#include "wire/json.hpp"
+
+namespace
+{
+  using clock = std::chrono::steady_clock;
+
+  constexpr const unsigned repeats = 5; //!< Best of, to filter scheduler noise
+
+  volatile std::size_t sink = 0; //!< Keeps results of measured calls alive
+
+  /*! \return Best nanoseconds per call of `op`, over `repeats` runs of
+      `iterations` calls. */
+  template<typename F>
+  double measure(const std::size_t iterations, F op)
+  {
+    double best = 0;
+    for (unsigned repeat = 0; repeat < repeats; ++repeat)
+    {
+      const auto start = clock::now();
+      for (std::size_t i = 0; i < iterations; ++i)
+        op();
+      const double elapsed = std::chrono::duration<double, std::nano>(clock::now() - start).count() / iterations;
+      best = repeat ? std::min(best, elapsed) : elapsed;
+    }
+    return best;
+  }
+
+  void report(const char* name, const double ns, const std::size_t bytes)
+  {
+    if (bytes)
+      std::printf("  %-40s %12.0f ns/op %10.1f MB/s\n", name, ns, bytes * 1000.0 / ns);
+    else
+      std::printf("  %-40s %12.0f ns/op %10.0f op/s\n", name, ns, 1e9 / ns);
+  }
+
+  byte_slice make_slice(const std::string& source)
+  {
+    byte_stream out{source.size()};
+    out.write(source.data(), source.size());
+    return byte_slice{std::move(out)};
+  }
+
+  //! \return Quoted hex of a hash derived from `value`; uniform like real tx hashes.
+  std::string hex_hash(const unsigned value)
+  {
+    std::uint64_t state = value;
+    std::string out = "\"";
+    for (unsigned i = 0; i < 4; ++i)
+    {
+      // splitmix64
+      std::uint64_t word = (state += 0x9E3779B97F4A7C15ull);
+      word = (word ^ (word >> 30)) * 0xBF58476D1CE4E5B9ull;
+      word = (word ^ (word >> 27)) * 0x94D049BB133111EBull;
+      word ^= word >> 31;
+
+      char hex[17] = {};
+      std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(word));
+      out += hex;
+    }
+    return out + "\"";
+  }
+
+  //! Appends `bytes` in 64 byte writes, like the ZMQ receive and JSON write paths.
+  template<typename Growth>
+  std::size_t fill(basic_byte_stream<Growth>& out, const std::size_t bytes)
+  {
+    static const std::uint8_t chunk[64] = {};
+    for (std::size_t written = 0; written < bytes; written += sizeof(chunk))
+      out.write(chunk, std::min(sizeof(chunk), bytes - written));
+    return out.size();
+  }
+
+  //! `byte_stream` growth policies, as used by `zmq::receive` and JSON output.
+  void growth()
+  {
+    std::printf("byte_stream growth (64 byte writes)\n");
+    for (const std::size_t bytes : {std::size_t(10) << 10, std::size_t(1) << 20, std::size_t(16) << 20})
+    {
+      const std::size_t iterations = std::max(std::size_t(1), (std::size_t(64) << 20) / bytes / 4);
+      std::printf(" %zu bytes\n", bytes);
+      report("linear_growth", measure(iterations, [bytes] {
+        basic_byte_stream<linear_growth> out{}; fill(out, bytes);
+      }), bytes);
+      report("geometric_growth", measure(iterations, [bytes] {
+        basic_byte_stream<geometric_growth> out{}; fill(out, bytes);
+      }), bytes);
+      report("hinted_growth (exact hint)", measure(iterations, [bytes] {
+        basic_byte_stream<hinted_growth> out{bytes}; fill(out, bytes);
+      }), bytes);
+      report("reserve_exact + linear_growth", measure(iterations, [bytes] {
+        basic_byte_stream<linear_growth> out{}; out.reserve_exact(bytes); fill(out, bytes);
+      }), bytes);
+    }
+  }
+
+  //! Full rapidjson SAX parse of `source`, the cost of decoding without skipping.
+  void rapidjson_parse(const std::string& source)
+  {
+    rapidjson::Reader reader{};
+    rapidjson::MemoryStream stream{source.data(), source.size()};
+    rapidjson::BaseReaderHandler<> handler{};
+    if (!reader.Parse(stream, handler))
+      throw std::runtime_error{"rapidjson parse failed"};
+  }
+
+  //! Fields of one decoded object, and the slot table `json_reader::key` probes.
+  class key_set
+  {
+    std::vector<wire::json_reader::key_map> map_;
+    std::vector<std::uint8_t> slots_;
+
+  public:
+    explicit key_set(const std::initializer_list<const char*> names)
+      : map_(), slots_(wire::json_reader::key_slots(names.size()))
+    {
+      std::vector<std::uint32_t> hashes{};
+      for (const char* name : names)
+      {
+        const std::size_t length = std::strlen(name);
+        map_.push_back({name, length, wire::key_hash(name, length)});
+        hashes.push_back(map_.back().hash);
+      }
+      wire::json_reader::index_keys(to_span(hashes), to_mut_span(slots_));
+    }
+
+    //! \return Index of `key`, as found by `json_reader::key`.
+    std::size_t find(const span<const char> key) const noexcept
+    {
+      return wire::json_reader::find_key(to_span(map_), to_span(slots_), key);
+    }
+
+    //! \return Index of `key`, by `strlen` and `memcmp` of every field like before hashing.
+    std::size_t scan(const span<const char> key) const noexcept
+    {
+      for (std::size_t i = 0; i < map_.size(); ++i)
+      {
+        const std::size_t length = std::strlen(map_[i].name);
+        if (key.size() == length && std::memcmp(key.data(), map_[i].name, length) == 0)
+          return i;
+      }
+      return map_.size();
+    }
+  };
+
+  //! Every object key in a reply, with the depth (root is 1) of its object.
+  struct key_collector : rapidjson::BaseReaderHandler<rapidjson::UTF8<>, key_collector>
+  {
+    std::vector<std::pair<std::size_t, std::string>> keys;
+    std::size_t depth = 0;
+
+    bool StartObject() { ++depth; return true; }
+    bool EndObject(rapidjson::SizeType) { --depth; return true; }
+    bool Key(const char* str, const rapidjson::SizeType length, bool)
+    {
+      keys.emplace_back(depth, std::string{str, length});
+      return true;
+    }
+  };
+
+  /*! Key lookups done while decoding `reply`, with `sets[depth - 1]` as the
+      fields of each object. Only dispatch is timed, not the parse. */
+  void key_dispatch(const char* name, const std::string& reply, const std::vector<const key_set*>& sets, const std::size_t iterations)
+  {
+    key_collector collected{};
+    rapidjson::Reader reader{};
+    rapidjson::MemoryStream stream{reply.data(), reply.size()};
+    if (!reader.Parse(stream, collected))
+      throw std::runtime_error{"rapidjson parse failed"};
+
+    std::vector<std::pair<const key_set*, span<const char>>> lookups{};
+    for (const auto& key : collected.keys)
+    {
+      if (key.first <= sets.size())
+        lookups.emplace_back(sets[key.first - 1], span<const char>{key.second.data(), key.second.size()});
+    }
+
+    std::printf(" %s, %zu keys\n", name, lookups.size());
+    report("json_reader::find_key", measure(iterations, [&lookups] {
+      std::size_t found = 0;
+      for (const auto& lookup : lookups)
+        found += lookup.first->find(lookup.second);
+      sink = found;
+    }), 0);
+    report("strlen/memcmp scan (before hashing)", measure(iterations, [&lookups] {
+      std::size_t found = 0;
+      for (const auto& lookup : lookups)
+        found += lookup.first->scan(lookup.second);
+      sink = found;
+    }), 0);
+  }
+
+  //! RPC replies, where most keys and values are unknown and skipped.
+  void decode()
+  {
+    std::printf("JSON decode\n");
+
+    // keys and value sizes follow a `get_info` reply from monerod
+    std::string info =
+      "{\"id\":0,\"jsonrpc\":\"2.0\",\"result\":{\"info\":{\"adjusted_time\":1700000000,\"alt_blocks_count\":0,"
+      "\"block_size_limit\":600000,\"block_size_median\":300000,\"block_weight_limit\":600000,"
+      "\"block_weight_median\":300000,\"bootstrap_daemon_address\":\"\",\"busy_syncing\":false,"
+      "\"credits\":0,\"cumulative_difficulty\":365512301264832128,\"cumulative_difficulty_top64\":0,"
+      "\"database_size\":193273528320,\"difficulty\":297483214835,\"difficulty_top64\":0,"
+      "\"free_space\":1073741824000,\"grey_peerlist_size\":4985,\"height\":3000000,"
+      "\"height_without_bootstrap\":3000000,\"incoming_connections_count\":12,\"mainnet\":true,"
+      "\"nettype\":\"mainnet\",\"offline\":false,\"outgoing_connections_count\":16,"
+      "\"restricted\":false,\"rpc_connections_count\":1,\"stagenet\":false,"
+      "\"start_time\":1690000000,\"status\":\"OK\",\"synchronized\":true,\"target\":120,"
+      "\"target_height\":0,\"testnet\":false,\"top_block_hash\":" + hex_hash(1) + ","
+      "\"top_hash\":\"\",\"tx_count\":40000000,\"tx_pool_size\":25,\"untrusted\":false,"
+      "\"update_available\":false,\"version\":\"0.18.3.1-release\",\"was_bootstrap_ever_used\":false,"
+      "\"white_peerlist_size\":1000,\"wide_cumulative_difficulty\":\"0x5128a9e1b5d3c80\","
+      "\"wide_difficulty\":\"0x4543d8e2f3\"},\"status\":\"OK\"}}";
+
+    // `tx_blob` and `tx_json` are skipped, and dominate the reply size
+    std::string pool = "{\"id\":0,\"jsonrpc\":\"2.0\",\"result\":{\"credits\":0,\"spent_key_images\":[],\"status\":\"OK\",\"transactions\":[";
+    std::string hashes = "{\"id\":0,\"jsonrpc\":\"2.0\",\"result\":{\"credits\":0,\"status\":\"OK\",\"tx_hashes\":[";
+    const std::string blob(3000, 'a');
+    std::string tx_json = "{\\n  \\\"version\\\": 2, \\n  \\\"vin\\\": [ {\\n    \\\"key\\\": {\\n      \\\"amount\\\": 0}}], \\n  \\\"extra\\\": [";
+    for (unsigned i = 0; i < 300; ++i)
+      tx_json += "1, 2, 3, ";
+    tx_json += "4]\\n}";
+    for (unsigned i = 0; i < 1000; ++i)
+    {
+      if (i)
+      {
+        pool += ",";
+        hashes += ",";
+      }
+      pool +=
+        "{\"blob_size\":1500,\"do_not_relay\":false,\"double_spend_seen\":false,\"fee\":30000000,"
+        "\"id_hash\":" + hex_hash(i) + ",\"kept_by_block\":false,\"last_failed_height\":0,"
+        "\"last_failed_id_hash\":" + hex_hash(0) + ",\"last_relayed_time\":1700000000,"
+        "\"max_used_block_height\":2999990,\"max_used_block_id_hash\":" + hex_hash(2) + ","
+        "\"receive_time\":1700000000,\"relayed\":true,\"tx_blob\":\"" + blob + "\","
+        "\"tx_hash\":" + hex_hash(i) + ",\"tx_json\":\"" + tx_json + "\",\"weight\":1500}";
+      hashes += hex_hash(i);
+    }
+    pool += "],\"untrusted\":false}}";
+    hashes += "],\"untrusted\":false}}";
+
+    const byte_slice info_bytes = make_slice(info);
+    report("get_info", measure(200000, [&info_bytes] {
+      wire::json::from_bytes<rpc::json<method::get_info>::response>(info_bytes.clone());
+    }), info.size());
+    report("get_info (rapidjson full parse)", measure(200000, [&info] { rapidjson_parse(info); }), info.size());
+
+    const byte_slice pool_bytes = make_slice(pool);
+    report("get_transaction_pool, 1000 txes", measure(20, [&pool_bytes] {
+      const arena::scope message{};
+      wire::json::from_bytes<rpc::json<method::get_transaction_pool>::response>(pool_bytes.clone());
+    }), pool.size());
+    report("get_transaction_pool (rapidjson full parse)", measure(20, [&pool] { rapidjson_parse(pool); }), pool.size());
+
+    const byte_slice hash_bytes = make_slice(hashes);
+    report("get_transaction_pool_hashes, 1000 txes", measure(2000, [&hash_bytes] {
+      wire::json::from_bytes<rpc::json<method::get_transaction_pool_hashes>::response>(hash_bytes.clone());
+    }), hashes.size());
+
+    // fields decoded by `rpc::json` and `method`, at each object depth
+    std::printf("JSON key dispatch (keys of the replies above)\n");
+    const key_set response{"id", "result"};
+    const key_set info_result{"info"};
+    const key_set info_fields{
+      "height", "target_height", "outgoing_connections_count", "incoming_connections_count",
+      "top_block_hash", "mainnet", "testnet", "stagenet"
+    };
+    const key_set pool_result{"transactions"};
+    const key_set tx_fields{"tx_hash"};
+    key_dispatch("get_info", info, {&response, &info_result, &info_fields}, 200000);
+    key_dispatch("get_transaction_pool", pool, {&response, &pool_result, &tx_fields}, 2000);
+  }
+
+  //! Malformed pubs, decoded with and without exceptions.
+  void malformed()
+  {
+    std::printf("Malformed pub decode (json-minimal-txpool_add)\n");
+
+    std::string valid = "[";
+    for (unsigned i = 0; i < 10; ++i)
+      valid += (i ? ",{\"id\":" : "{\"id\":") + hex_hash(i) + ",\"blob_size\":1500,\"weight\":1500,\"fee\":30000000}";
+    valid += "]";
+
+    // wrong type in the last entry, so most of the message is read first
+    std::string invalid = valid;
+    invalid.replace(invalid.rfind("\"id\":") + 5, 66, "12345");
+
+    const byte_slice valid_bytes = make_slice(valid);
+    const byte_slice invalid_bytes = make_slice(invalid);
+    pub::minimal_txpool dest{};
+    wire::json_reader reader{};
+
+    report("valid, try_from_bytes", measure(100000, [&] {
+      if (!wire::json::try_from_bytes(valid_bytes.clone(), dest, reader))
+        throw std::runtime_error{"valid pub failed"};
+    }), 0);
+    report("malformed, try_from_bytes", measure(100000, [&] {
+      if (wire::json::try_from_bytes(invalid_bytes.clone(), dest, reader))
+        throw std::runtime_error{"malformed pub decoded"};
+    }), 0);
+    report("malformed, from_bytes (throws)", measure(100000, [&] {
+      try
+      {
+        wire::json::from_bytes<pub::minimal_txpool>(invalid_bytes.clone());
+        throw std::runtime_error{"malformed pub decoded"};
+      }
+      catch (const std::system_error&)
+      {}
+    }), 0);
+  }
+}
+
+int main()
+{
+  try
+  {
+    growth();
+    decode();
+    malformed();
+  }
+  catch (const std::exception& e)
+  {
+    std::fprintf(stderr, "bench failed: %s\n", e.what());
+    return 1;
+  }
+  return 0;
+}
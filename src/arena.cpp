@@ -0,0 +1,123 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+
+#include "buffer_pool.hpp"
+
+namespace
+{
+  constexpr const std::size_t min_chunk_size = 4 * 1024;
+  constexpr const std::size_t max_chunk_size = 1024 * 1024;
+
+  thread_local arena* current_arena = nullptr;
+
+  //! \return Bytes needed to align `ptr` to `align`.
+  std::size_t padding(const unsigned char* ptr, const std::size_t align) noexcept
+  {
+    return (align - (reinterpret_cast<std::uintptr_t>(ptr) & (align - 1))) & (align - 1);
+  }
+}
+
+struct alignas(alignof(std::max_align_t)) arena::chunk
+{
+  chunk* prior;
+};
+
+void* arena::allocate_chunk(const std::size_t size, const std::size_t align) noexcept
+{
+  const std::size_t overhead = sizeof(chunk) + align;
+  if (std::numeric_limits<std::size_t>::max() - overhead < size)
+    return nullptr;
+
+  // oversized requests get a chunk of their own
+  const std::size_t capacity = std::max(std::max(next_size_, min_chunk_size), size + overhead);
+  void* const memory = buffer_pool::allocate(capacity);
+  if (!memory)
+    return nullptr;
+
+  head_ = ::new(memory) chunk{head_};
+  next_ = reinterpret_cast<unsigned char*>(head_ + 1);
+  end_ = static_cast<unsigned char*>(memory) + capacity;
+  next_size_ = std::min(capacity * 2, max_chunk_size);
+
+  unsigned char* const out = next_ + padding(next_, align);
+  next_ = out + size;
+  return out;
+}
+
+void* arena::allocate(const std::size_t size, const std::size_t align) noexcept
+{
+  if (head_)
+  {
+    const std::size_t pad = padding(next_, align);
+    const std::size_t available = end_ - next_;
+    if (pad <= available && size <= available - pad)
+    {
+      unsigned char* const out = next_ + pad;
+      next_ = out + size;
+      return out;
+    }
+  }
+  return allocate_chunk(size, align);
+}
+
+void arena::release() noexcept
+{
+  while (head_)
+  {
+    chunk* const prior = head_->prior;
+    buffer_pool::release(head_);
+    head_ = prior;
+  }
+  next_ = nullptr;
+  end_ = nullptr;
+  next_size_ = 0;
+}
+
+arena* arena::current() noexcept
+{
+  return current_arena;
+}
+
+arena::scope::scope() noexcept
+  : memory_(), prior_(current_arena)
+{
+  current_arena = std::addressof(memory_);
+}
+
+arena::scope::~scope() noexcept
+{
+  current_arena = prior_;
+}
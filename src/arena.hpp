@@ -0,0 +1,149 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOTRIX_ARENA_HPP
+#define MOTRIX_ARENA_HPP
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <new>
+
+/*! \brief Monotonic allocator for values decoded from one message.
+
+    Memory is carved from chunks taken from `buffer_pool`, and individual
+    deallocations are no-ops; every chunk goes back to the pool at once in
+    `release()` or the destructor. Chunks double in size, so a message needs
+    a handful of pool calls regardless of how many objects it holds. Not
+    thread-safe. */
+class arena
+{
+  struct chunk;
+
+  chunk* head_;
+  unsigned char* next_; //!< Free space in `head_`
+  unsigned char* end_;
+  std::size_t next_size_; //!< Capacity of next chunk
+
+  //! \return New chunk with `size` bytes available at `align`, or `nullptr`.
+  void* allocate_chunk(std::size_t size, std::size_t align) noexcept;
+
+public:
+  class scope;
+
+  arena() noexcept
+    : head_(nullptr), next_(nullptr), end_(nullptr), next_size_(0)
+  {}
+
+  arena(const arena&) = delete;
+  arena& operator=(const arena&) = delete;
+
+  ~arena() noexcept { release(); }
+
+  //! \return `size` bytes aligned to `align` (power of 2), or `nullptr` on failure.
+  void* allocate(std::size_t size, std::size_t align) noexcept;
+
+  //! Return all chunks to `buffer_pool`; all prior allocations become invalid.
+  void release() noexcept;
+
+  //! \return Arena of innermost `scope` on the calling thread, or `nullptr`.
+  static arena* current() noexcept;
+};
+
+/*! Installs a fresh `arena` as `arena::current()` for the calling thread,
+    until destruction (which releases it). Scopes can nest. */
+class arena::scope
+{
+  arena memory_;
+  arena* const prior_;
+
+public:
+  scope() noexcept;
+  ~scope() noexcept;
+
+  scope(const scope&) = delete;
+  scope& operator=(const scope&) = delete;
+};
+
+/*! \brief Standard allocator using an `arena`.
+
+    Default construction binds to `arena::current()`, so containers decoded
+    within an `arena::scope` draw from it without any wiring; outside of a
+    scope, `operator new` is used. A container using an arena must not
+    outlive it. */
+template<typename T>
+class arena_allocator
+{
+  arena* arena_;
+
+  template<typename> friend class arena_allocator;
+
+public:
+  using value_type = T;
+
+  arena_allocator() noexcept
+    : arena_(arena::current())
+  {}
+
+  explicit arena_allocator(arena& memory) noexcept
+    : arena_(std::addressof(memory))
+  {}
+
+  template<typename U>
+  arena_allocator(const arena_allocator<U>& rhs) noexcept
+    : arena_(rhs.arena_)
+  {}
+
+  //! \throw std::bad_alloc on failure.
+  T* allocate(const std::size_t count)
+  {
+    if (std::numeric_limits<std::size_t>::max() / sizeof(T) < count)
+      throw std::bad_alloc{};
+    if (!arena_)
+      return static_cast<T*>(::operator new(count * sizeof(T)));
+
+    void* const out = arena_->allocate(count * sizeof(T), alignof(T));
+    if (!out)
+      throw std::bad_alloc{};
+    return static_cast<T*>(out);
+  }
+
+  void deallocate(T* const ptr, std::size_t) noexcept
+  {
+    if (!arena_)
+      ::operator delete(ptr);
+  }
+
+  template<typename U>
+  bool operator==(const arena_allocator<U>& rhs) const noexcept { return arena_ == rhs.arena_; }
+
+  template<typename U>
+  bool operator!=(const arena_allocator<U>& rhs) const noexcept { return arena_ != rhs.arena_; }
+};
+
+#endif // MOTRIX_ARENA_HPP
@@ -0,0 +1,283 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "buffer_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+#include "stats.hpp"
+
+namespace buffer_pool
+{
+  namespace
+  {
+    constexpr const std::size_t min_class_size = 128;
+    constexpr const std::size_t class_count = 16; //!< 128 B to 4 MiB
+    constexpr const std::size_t no_class = class_count;
+
+    //! Bytes each thread caches per size class, within `[min_cached, max_cached]` blocks
+    constexpr const std::size_t thread_cache_bytes = 256 * 1024;
+    constexpr const std::size_t min_cached = 2;
+    constexpr const std::size_t max_cached = 64;
+
+    //! Precedes every block. `next` is only used while in a free list.
+    struct alignas(alignof(std::max_align_t)) header
+    {
+      header* next;
+      std::size_t capacity; //!< Usable bytes after `this` header
+    };
+
+    constexpr std::size_t class_size(const std::size_t index) noexcept
+    {
+      return min_class_size << index;
+    }
+
+    //! \return Smallest size class that fits `size`, or `no_class`.
+    std::size_t find_class(const std::size_t size) noexcept
+    {
+      std::size_t index = 0;
+      while (index < class_count && class_size(index) < size)
+        ++index;
+      return index;
+    }
+
+    std::size_t cache_limit(const std::size_t index) noexcept
+    {
+      return std::max(min_cached, std::min(max_cached, thread_cache_bytes / class_size(index)));
+    }
+
+    stats::counter hits{"buffer_pool.hits"};
+    stats::counter misses{"buffer_pool.misses"};
+    stats::counter oversized{"buffer_pool.oversized"};
+    stats::gauge in_use{"buffer_pool.bytes_in_use"};
+
+    /* Blocks are pushed in batches with CAS, and popped by taking the entire
+       list with an exchange. Neither operation is susceptible to ABA, so no
+       tagged pointers or hazard pointers are needed. Constant initialized,
+       and never destroyed, so usable from any static constructor or
+       destructor. */
+    std::atomic<header*> global_free[class_count] = {};
+
+    void push_global(const std::size_t index, header* const first, header* const last) noexcept
+    {
+      header* head = global_free[index].load(std::memory_order_relaxed);
+      do
+      {
+        last->next = head;
+      } while (!global_free[index].compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    header* take_global(const std::size_t index) noexcept
+    {
+      return global_free[index].exchange(nullptr, std::memory_order_acquire);
+    }
+
+    struct thread_cache
+    {
+      header* free[class_count];
+      std::size_t count[class_count];
+
+      thread_cache() noexcept
+        : free(), count()
+      {}
+
+      ~thread_cache() noexcept;
+
+      //! \return Cached block of size class `index`, or `nullptr`.
+      header* pop(const std::size_t index) noexcept
+      {
+        if (!free[index])
+        {
+          free[index] = take_global(index);
+          for (header const* current = free[index]; current; current = current->next)
+            ++count[index];
+        }
+
+        header* const block = free[index];
+        if (block)
+        {
+          free[index] = block->next;
+          --count[index];
+        }
+        return block;
+      }
+
+      void push(const std::size_t index, header* const block) noexcept
+      {
+        block->next = free[index];
+        free[index] = block;
+        if (cache_limit(index) < ++count[index])
+          trim(index, cache_limit(index) / 2);
+      }
+
+      //! Move all but `keep` blocks of size class `index` to global list.
+      void trim(const std::size_t index, const std::size_t keep) noexcept
+      {
+        if (count[index] <= keep)
+          return;
+
+        header* first = free[index];
+        if (keep)
+        {
+          header* last_kept = first;
+          for (std::size_t i = 1; i < keep; ++i)
+            last_kept = last_kept->next;
+          first = last_kept->next;
+          last_kept->next = nullptr;
+        }
+        else
+          free[index] = nullptr;
+
+        header* last = first;
+        while (last->next)
+          last = last->next;
+
+        push_global(index, first, last);
+        count[index] = keep;
+      }
+    };
+
+    // constant initialized; remains valid after `cache` is destroyed
+    thread_local bool cache_destroyed = false;
+    thread_local thread_cache cache{};
+
+    thread_cache::~thread_cache() noexcept
+    {
+      for (std::size_t index = 0; index < class_count; ++index)
+        trim(index, 0);
+      cache_destroyed = true;
+    }
+
+    //! \return Cache for this thread, or `nullptr` if thread is exiting.
+    thread_cache* get_cache() noexcept
+    {
+      return cache_destroyed ? nullptr : std::addressof(cache);
+    }
+
+    header* allocate_block(const std::size_t capacity) noexcept
+    {
+      header* const block = static_cast<header*>(std::malloc(sizeof(header) + capacity));
+      if (block)
+        block->capacity = capacity;
+      return block;
+    }
+  } // anonymous
+
+  void* allocate(const std::size_t size) noexcept
+  {
+    if (std::numeric_limits<std::size_t>::max() - sizeof(header) < size)
+      return nullptr;
+
+    const std::size_t index = find_class(size);
+    if (index == no_class)
+    {
+      oversized.increment();
+      header* const block = allocate_block(size);
+      return block ? block + 1 : nullptr;
+    }
+
+    thread_cache* const local = get_cache();
+    header* block = local ? local->pop(index) : nullptr;
+    if (block)
+      hits.increment();
+    else
+    {
+      misses.increment();
+      block = allocate_block(class_size(index));
+      if (!block)
+        return nullptr;
+    }
+
+    in_use.add(block->capacity);
+    return block + 1;
+  }
+
+  std::size_t usable_size(const std::size_t size) noexcept
+  {
+    const std::size_t index = find_class(size);
+    return index == no_class ? size : class_size(index);
+  }
+
+  void* reallocate(void* const ptr, const std::size_t size) noexcept
+  {
+    if (!ptr)
+      return allocate(size);
+
+    header* const block = static_cast<header*>(ptr) - 1;
+    if (size <= block->capacity && find_class(block->capacity) != no_class)
+      return ptr;
+
+    if (find_class(block->capacity) == no_class && find_class(size) == no_class)
+    {
+      if (std::numeric_limits<std::size_t>::max() - sizeof(header) < size)
+        return nullptr;
+
+      // oversized blocks bypass the pool, so the C runtime can resize in place
+      oversized.increment();
+      header* const resized = static_cast<header*>(std::realloc(block, sizeof(header) + size));
+      if (!resized)
+        return nullptr;
+      resized->capacity = size;
+      return resized + 1;
+    }
+
+    void* const out = allocate(size);
+    if (out)
+    {
+      std::memcpy(out, ptr, std::min(size, block->capacity));
+      release(ptr);
+    }
+    return out;
+  }
+
+  void release(void* const ptr) noexcept
+  {
+    if (!ptr)
+      return;
+
+    header* const block = static_cast<header*>(ptr) - 1;
+    const std::size_t index = find_class(block->capacity);
+    if (index == no_class)
+    {
+      std::free(block);
+      return;
+    }
+
+    in_use.subtract(block->capacity);
+    thread_cache* const local = get_cache();
+    if (local)
+      local->push(index, block);
+    else
+      push_global(index, block, block);
+  }
+}
@@ -0,0 +1,69 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOTRIX_BUFFER_POOL_HPP
+#define MOTRIX_BUFFER_POOL_HPP
+
+#include <cstddef>
+
+/*! \brief Size-classed recycling allocator for `byte_slice` and `byte_buffer`.
+
+    Blocks are rounded up to a power-of-two size class (see `usable_size`),
+    and released blocks are kept for re-use instead of being returned to the
+    C runtime. A released block goes to a cache owned by the releasing
+    thread, which holds up to 256 KiB per size class (2 to 64 blocks). Only
+    when that cache overflows, or the thread exits, are blocks moved to a
+    global lock-free list, from which a thread with an empty cache takes
+    them. So a block freed on a ZMQ I/O thread usually stays in that
+    thread's cache. Memory held by the pool can exceed the high-water mark
+    of blocks in use by what the per-thread caches hold.
+
+    Requests larger than the biggest size class bypass the pool. */
+namespace buffer_pool
+{
+  /*! \return Block of at least `size` bytes aligned for any type, or
+        `nullptr` on allocation failure. */
+  void* allocate(std::size_t size) noexcept;
+
+  /*! \return Usable bytes of a block from `allocate(size)`: `size` rounded
+        up to its size class, or `size` if it bypasses the pool. */
+  std::size_t usable_size(std::size_t size) noexcept;
+
+  /*! Resize `ptr` (from `allocate` or `reallocate`) to at least `size` bytes.
+      Bytes are retained up to the smaller of the old and new size. If `ptr`
+      is already large enough, `ptr` is returned without a copy.
+
+      \return Resized block, or `nullptr` on allocation failure (`ptr` is
+        still valid). */
+  void* reallocate(void* ptr, std::size_t size) noexcept;
+
+  //! Return `ptr` (from `allocate` or `reallocate`) to the pool. Thread-safe.
+  void release(void* ptr) noexcept;
+}
+
+#endif // MOTRIX_BUFFER_POOL_HPP
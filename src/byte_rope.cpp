@@ -0,0 +1,80 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "byte_rope.hpp"
+
+#include <utility>
+
+  byte_rope byte_rope::clone() const
+  {
+    byte_rope out{head_.clone()};
+    out.tail_.reserve(tail_.size() - front_);
+    for (std::size_t i = front_; i < tail_.size(); ++i)
+      out.tail_.push_back(tail_[i].clone());
+    out.size_ = size_;
+    return out;
+  }
+
+  void byte_rope::push_back(byte_slice&& source)
+  {
+    if (source.empty())
+      return;
+
+    const std::size_t added = source.size();
+    if (head_.empty())
+      head_ = std::move(source);
+    else
+      tail_.push_back(std::move(source));
+    size_ += added;
+  }
+
+  std::size_t byte_rope::remove_prefix(std::size_t max_bytes) noexcept
+  {
+    std::size_t removed = 0;
+    while (removed < max_bytes && !head_.empty())
+    {
+      removed += head_.remove_prefix(max_bytes - removed);
+      if (head_.empty() && front_ < tail_.size())
+        head_ = std::move(tail_[front_++]);
+    }
+
+    // moved-from segments are dropped in bulk, instead of shifting `tail_` per segment
+    if (front_ == tail_.size())
+    {
+      tail_.clear();
+      front_ = 0;
+    }
+    else if (tail_.size() <= front_ * 2)
+    {
+      tail_.erase(tail_.begin(), tail_.begin() + front_);
+      front_ = 0;
+    }
+    size_ -= removed;
+    return removed;
+  }
+
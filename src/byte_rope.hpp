@@ -0,0 +1,93 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOTRIX_BYTE_ROPE_HPP
+#define MOTRIX_BYTE_ROPE_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "byte_slice.hpp"
+
+  /*! \brief Ordered list of `byte_slice` segments.
+
+      Multipart messages can be kept as-is (each part adopted without a copy)
+      instead of being coalesced into a single buffer. The first segment is
+      stored inline, so a single segment rope has zero allocations. Empty
+      segments are never stored. */
+  class byte_rope
+  {
+    byte_slice head_;
+    std::vector<byte_slice> tail_;
+    std::size_t front_; //!< Index of first `tail_` segment not yet removed
+    std::size_t size_; //!< Total bytes in all segments
+
+  public:
+    //! Construct empty rope.
+    byte_rope() noexcept
+      : head_(), tail_(), front_(0), size_(0)
+    {}
+
+    //! Construct rope with `source` as the only segment.
+    byte_rope(byte_slice&& source) noexcept
+      : head_(std::move(source)), tail_(), front_(0), size_(head_.size())
+    {}
+
+    byte_rope(byte_rope&&) = default;
+    ~byte_rope() noexcept = default;
+    byte_rope& operator=(byte_rope&&) = default;
+
+    //! \return Shallow (cheap) copy of every segment.
+    byte_rope clone() const;
+
+    bool empty() const noexcept { return size_ == 0; }
+
+    //! \return Total number of bytes in all segments.
+    std::size_t size() const noexcept { return size_; }
+
+    //! \return Number of segments.
+    std::size_t segments() const noexcept { return head_.empty() ? 0 : 1 + tail_.size() - front_; }
+
+    //! \return Segment at `index`. \pre `index < segments()`.
+    const byte_slice& segment(const std::size_t index) const noexcept
+    {
+      return index ? tail_[front_ + index - 1] : head_;
+    }
+
+    //! Append `source` as the last segment. \throw std::bad_alloc
+    void push_back(byte_slice&& source);
+
+    /*! Drop bytes from the beginning of `this` rope. Removed segments are
+        compacted once they are half of `tail_`, so draining a rope is linear.
+
+        \note May invalidate previously retrieved pointers.
+        \return Number of bytes removed. */
+    std::size_t remove_prefix(std::size_t max_bytes) noexcept;
+  };
+
+#endif // MOTRIX_BYTE_ROPE_HPP
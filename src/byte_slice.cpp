@@ -27,27 +27,15 @@
 // THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <atomic>
-#include <cstdlib>
 #include <cstring>
 #include <limits>
 #include <stdexcept>
 #include <utility>
 
+#include "buffer_pool.hpp"
 #include "byte_slice.hpp"
 #include "byte_stream.hpp"
 
-  struct byte_slice_data
-  {
-    byte_slice_data() noexcept
-      : ref_count(1)
-    {}
-
-    virtual ~byte_slice_data() noexcept
-    {}
-
-    std::atomic<std::size_t> ref_count;
-  };
-
   void release_byte_slice::call(void*, void* ptr) noexcept
   {
     if (ptr)
@@ -56,7 +44,7 @@
       if (--(self->ref_count) == 0)
       {
         self->~byte_slice_data();
-        free(self);
+        buffer_pool::release(self);
       }
     }
   }
@@ -86,40 +74,12 @@
       virtual ~raw_byte_slice() noexcept final override
       {}
     };
-
-    /* This technique is not-standard, but allows for the reference count and
-       memory for the bytes (when given a list of spans) to be allocated in a
-       single call. In that situation, the dynamic sized bytes are after/behind
-       the raw_byte_slice class. The C runtime has to track the number of bytes
-       allocated regardless, so free'ing is relatively easy. */
-
-    template<typename T, typename... U>
-    std::unique_ptr<T, release_byte_slice> allocate_slice(std::size_t extra_bytes, U&&... args)
-    {
-      if (std::numeric_limits<std::size_t>::max() - sizeof(T) < extra_bytes)
-        throw std::bad_alloc{};
-
-      void* const ptr = malloc(sizeof(T) + extra_bytes);
-      if (ptr == nullptr)
-        throw std::bad_alloc{};
-
-      try
-      {
-        new (ptr) T{std::forward<U>(args)...};
-      }
-      catch (...)
-      {
-        free(ptr);
-        throw;
-      }
-      return std::unique_ptr<T, release_byte_slice>{reinterpret_cast<T*>(ptr)};
-    }
   } // anonymous
 
   void release_byte_buffer::operator()(std::uint8_t* buf) const noexcept
   {
     if (buf)
-      std::free(buf - sizeof(raw_byte_slice));
+      buffer_pool::release(buf - sizeof(raw_byte_slice));
   }
 
   byte_slice::byte_slice(byte_slice_data* storage, span<const std::uint8_t> portion) noexcept
@@ -129,6 +89,10 @@
       ++(storage_->ref_count);
   }
 
+  byte_slice::byte_slice(std::unique_ptr<byte_slice_data, release_byte_slice> storage, const span<const std::uint8_t> portion) noexcept
+    : storage_(std::move(storage)), portion_(portion)
+  {}
+
   template<typename T>
   byte_slice::byte_slice(const adapt_buffer, T&& buffer)
     : storage_(nullptr), portion_(nullptr)
@@ -163,7 +127,8 @@
     }
   }
 
-  byte_slice::byte_slice(byte_stream&& stream) noexcept
+  template<typename Growth>
+  byte_slice::byte_slice(basic_byte_stream<Growth>&& stream) noexcept
     : storage_(nullptr), portion_(stream.data(), stream.size())
   {
     std::uint8_t* const data = stream.take_buffer().release() - sizeof(raw_byte_slice);
@@ -171,6 +136,10 @@
     storage_.reset(reinterpret_cast<raw_byte_slice*>(data));
   }
 
+  template byte_slice::byte_slice(basic_byte_stream<linear_growth>&&) noexcept;
+  template byte_slice::byte_slice(basic_byte_stream<geometric_growth>&&) noexcept;
+  template byte_slice::byte_slice(basic_byte_stream<hinted_growth>&&) noexcept;
+
   byte_slice::byte_slice(byte_slice&& source) noexcept
     : storage_(std::move(source.storage_)), portion_(source.portion_)
   {
@@ -235,7 +204,7 @@
     if (data != nullptr)
       data -= sizeof(raw_byte_slice);
 
-    data = static_cast<std::uint8_t*>(std::realloc(data, sizeof(raw_byte_slice) + length));
+    data = static_cast<std::uint8_t*>(buffer_pool::reallocate(data, sizeof(raw_byte_slice) + length));
     if (data == nullptr)
       return nullptr;
 
@@ -244,6 +213,13 @@
     return buf;
   }
 
+  std::size_t byte_buffer_capacity(const std::size_t length) noexcept
+  {
+    if (std::numeric_limits<std::size_t>::max() - sizeof(raw_byte_slice) < length)
+      return length;
+    return buffer_pool::usable_size(sizeof(raw_byte_slice) + length) - sizeof(raw_byte_slice);
+  }
+
   byte_buffer byte_buffer_increase(byte_buffer buf, const std::size_t current, const std::size_t more)
   {
     if (std::numeric_limits<std::size_t>::max() - current < more)
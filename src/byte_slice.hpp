@@ -29,14 +29,32 @@
 #ifndef MOTRIX_BYTE_SLICE_HPP
 #define MOTRIX_BYTE_SLICE_HPP
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <memory>
+#include <new>
+#include <utility>
 
+#include "buffer_pool.hpp"
 #include "span.hpp"
 
-  struct byte_slice_data;
-  class byte_stream;
+  template<typename> class basic_byte_stream;
+
+  /*! Reference count for `byte_slice` storage. Derived types can own the bytes
+      (see `adapted_byte_slice`), and must be created with `allocate_slice`. */
+  struct byte_slice_data
+  {
+    byte_slice_data() noexcept
+      : ref_count(1)
+    {}
+
+    virtual ~byte_slice_data() noexcept
+    {}
+
+    std::atomic<std::size_t> ref_count;
+  };
 
   struct release_byte_slice
   {
@@ -48,6 +66,37 @@
     }
   };
 
+  /* This technique is not-standard, but allows for the reference count and
+     memory for the bytes (when given a list of spans) to be allocated in a
+     single call. In that situation, the dynamic sized bytes are after/behind
+     the `T` class. `buffer_pool` tracks the number of bytes allocated, so
+     free'ing is relatively easy. */
+
+  /*! \tparam T derived from `byte_slice_data`.
+      \throw std::bad_alloc on allocation failure.
+      \return `T` constructed from `args` with `extra_bytes` after it. */
+  template<typename T, typename... U>
+  std::unique_ptr<T, release_byte_slice> allocate_slice(std::size_t extra_bytes, U&&... args)
+  {
+    if (std::numeric_limits<std::size_t>::max() - sizeof(T) < extra_bytes)
+      throw std::bad_alloc{};
+
+    void* const ptr = buffer_pool::allocate(sizeof(T) + extra_bytes);
+    if (ptr == nullptr)
+      throw std::bad_alloc{};
+
+    try
+    {
+      new (ptr) T{std::forward<U>(args)...};
+    }
+    catch (...)
+    {
+      buffer_pool::release(ptr);
+      throw;
+    }
+    return std::unique_ptr<T, release_byte_slice>{reinterpret_cast<T*>(ptr)};
+  }
+
   //! Frees ref count + buffer allocated internally by `byte_buffer`.
   struct release_byte_buffer
   {
@@ -109,7 +158,14 @@
 //    explicit byte_slice(std::string&& buffer);
 
     //! Convert `stream` into a slice with zero allocations.
-    explicit byte_slice(byte_stream&& stream) noexcept;
+    template<typename Growth>
+    explicit byte_slice(basic_byte_stream<Growth>&& stream) noexcept;
+
+    /*! Take ownership of `storage` without changing its reference count.
+        Bytes in `portion` must be owned by `storage`, and remain valid until
+        `storage` is destroyed. Allows for zero-copy slices of "foreign"
+        buffers, such as a received `zmq_msg_t`. */
+    byte_slice(std::unique_ptr<byte_slice_data, release_byte_slice> storage, span<const std::uint8_t> portion) noexcept;
 
     byte_slice(byte_slice&& source) noexcept;
     ~byte_slice() noexcept = default;
@@ -160,10 +216,14 @@
   //! Alias for a buffer that has space for a `byte_slice` ref count.
   using byte_buffer = std::unique_ptr<std::uint8_t, release_byte_buffer>;
 
-  /*! \return `buf` with a new size of exactly `length`. New bytes not
+  /*! \return `buf` with a new size of at least `length`. New bytes not
         initialized. A `nullptr` is returned on allocation failure. */
   byte_buffer byte_buffer_resize(byte_buffer buf, std::size_t length) noexcept;
 
+  /*! \return Usable bytes of a buffer from `byte_buffer_resize(buf, length)`,
+        which is at least `length` since `buffer_pool` rounds up. */
+  std::size_t byte_buffer_capacity(std::size_t length) noexcept;
+
   /*! Increase `buf` of size `current` by `more` bytes.
 
     \throw std::range_error if `current + more` exceeds `size_t` bounds.
@@ -32,17 +32,11 @@
 #include <limits>
 #include <utility>
 
-  void byte_stream::overflow(const std::size_t requested)
+  template<typename Growth>
+  void basic_byte_stream<Growth>::grow(const std::size_t increase)
   {
-    // Recalculating `need` bytes removes at least one instruction from every
-    // inlined `put` call in header
-
-    assert(available() < requested);
-    const std::size_t need = requested - available();
-
     const std::size_t len = size();
     const std::size_t cap = capacity();
-    const std::size_t increase = std::max(need, increase_size());
 
     next_write_ = nullptr;
     end_ = nullptr;
@@ -51,11 +45,24 @@
     if (!buffer_)
       throw std::bad_alloc{};
 
+    // use the whole size class, so the next `grow` is not a copy within it
     next_write_ = buffer_.get() + len;
-    end_ = buffer_.get() + cap + increase;
+    end_ = buffer_.get() + byte_buffer_capacity(cap + increase);
   }
 
-  byte_stream::byte_stream(byte_stream&& rhs) noexcept
+  template<typename Growth>
+  void basic_byte_stream<Growth>::overflow(const std::size_t requested)
+  {
+    // Recalculating `need` bytes removes at least one instruction from every
+    // inlined `put` call in header
+
+    assert(available() < requested);
+    const std::size_t need = requested - available();
+    grow(Growth::increase(capacity(), need, increase_size()));
+  }
+
+  template<typename Growth>
+  basic_byte_stream<Growth>::basic_byte_stream(basic_byte_stream&& rhs) noexcept
     : buffer_(std::move(rhs.buffer_)),
       next_write_(rhs.next_write_),
       end_(rhs.end_),
@@ -65,7 +72,8 @@
     rhs.end_ = nullptr;
   }
 
-  byte_stream& byte_stream::operator=(byte_stream&& rhs) noexcept
+  template<typename Growth>
+  basic_byte_stream<Growth>& basic_byte_stream<Growth>::operator=(basic_byte_stream&& rhs) noexcept
   {
     if (this != std::addressof(rhs))
     {
@@ -79,10 +87,15 @@
     return *this;
   }
 
-  byte_buffer byte_stream::take_buffer() noexcept
+  template<typename Growth>
+  byte_buffer basic_byte_stream<Growth>::take_buffer() noexcept
   {
     byte_buffer out{std::move(buffer_)};
     next_write_ = nullptr;
     end_ = nullptr;
     return out;
   }
+
+  template class basic_byte_stream<linear_growth>;
+  template class basic_byte_stream<geometric_growth>;
+  template class basic_byte_stream<hinted_growth>;
@@ -29,6 +29,7 @@
 #ifndef MOTRIX_BYTE_STREAM_HPP
 #define MOTRIX_BYTE_STREAM_HPP
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <cstring>
@@ -36,6 +37,38 @@
 #include "byte_slice.hpp"
 #include "span.hpp"
 
+  /*! Grow buffer by `increase_size()` bytes (or exactly what is needed if
+      larger). Copies are O(n^2) with respect to final size, but wasted space
+      is bounded by `increase_size()`. */
+  struct linear_growth
+  {
+    static std::size_t increase(std::size_t, const std::size_t need, const std::size_t increase_size) noexcept
+    {
+      return std::max(need, increase_size);
+    }
+  };
+
+  /*! Grow buffer by 50% of current capacity, but never less than
+      `increase_size()` bytes. Copies are amortized O(n). */
+  struct geometric_growth
+  {
+    static std::size_t increase(const std::size_t capacity, const std::size_t need, const std::size_t increase_size) noexcept
+    {
+      return std::max(need, std::max(increase_size, capacity / 2));
+    }
+  };
+
+  /*! `increase_size()` is the expected total size - the first allocation is
+      exactly that size (if large enough). If the hint was too small, the
+      buffer doubles in capacity on every subsequent overflow. */
+  struct hinted_growth
+  {
+    static std::size_t increase(const std::size_t capacity, const std::size_t need, const std::size_t increase_size) noexcept
+    {
+      return std::max(need, capacity ? capacity : increase_size);
+    }
+  };
+
   /*! \brief A partial drop-in replacement for `std::ostream`.
 
       Only a few base `std::ostream` functions are implemented - enough for
@@ -51,14 +84,21 @@
         - Construction is significantly faster - the global `std::locale`
           does not have to be acquired (global thread synchronization), and
           an extra allocation for `std::stringbuf` is not needed (which is an
-          addition to the buffer inside of that object). */
-  class byte_stream
+          addition to the buffer inside of that object).
+
+      \tparam Growth One of `linear_growth`, `geometric_growth` or
+        `hinted_growth`. Determines buffer increase on overflow. */
+  template<typename Growth>
+  class basic_byte_stream
   {
     byte_buffer buffer_;        //! Beginning of buffer
     std::uint8_t* next_write_;  //! Current write position
     const std::uint8_t* end_;   //! End of buffer
     std::size_t increase_size_; //! Minimum buffer size increase
 
+    //! \post `capacity() >= old capacity() + increase`, rounded up by `buffer_pool`.
+    void grow(std::size_t increase);
+
     //! \post `requested <= available()`
     void overflow(const std::size_t requested);
 
@@ -73,26 +113,27 @@
   public:
     using char_type = std::uint8_t;
     using Ch = char_type;
+    using growth = Growth;
 
     //! \return Default minimum size increase on buffer overflow
     static constexpr std::size_t default_increase() noexcept { return 4096; }
 
-    //! Increase internal buffer by at least `byte_stream_increase` bytes.
-    byte_stream() noexcept
-      : byte_stream(default_increase())
+    //! Increase internal buffer by at least `default_increase()` bytes.
+    basic_byte_stream() noexcept
+      : basic_byte_stream(default_increase())
     {}
 
-    //! Increase internal buffer by at least `increase` bytes.
-    explicit byte_stream(const std::size_t increase) noexcept
+    //! Increase internal buffer by `increase` bytes, as defined by `Growth`.
+    explicit basic_byte_stream(const std::size_t increase) noexcept
       : buffer_(nullptr),
         next_write_(nullptr),
         end_(nullptr),
         increase_size_(increase)
     {}
 
-    byte_stream(byte_stream&& rhs) noexcept;
-    ~byte_stream() noexcept = default;
-    byte_stream& operator=(byte_stream&& rhs) noexcept;
+    basic_byte_stream(basic_byte_stream&& rhs) noexcept;
+    ~basic_byte_stream() noexcept = default;
+    basic_byte_stream& operator=(basic_byte_stream&& rhs) noexcept;
 
     //! \return The minimum increase size on buffer overflow
     std::size_t increase_size() const noexcept { return increase_size_; }
@@ -108,7 +149,7 @@
     {}
 
     /*! Reserve at least `more` bytes.
-        \post `size() + more <= available()`.
+        \post `more <= available()`.
         \throw std::range_error if exceeding max `size_t` value.
         \throw std::bad_alloc if allocation fails. */
     void reserve(const std::size_t more)
@@ -116,6 +157,18 @@
       check(more);
     }
 
+    /*! Reserve at least `more` bytes, ignoring `Growth`. Use when the final
+        size is known, to avoid over-allocation.
+        \post `more <= available()`.
+        \throw std::range_error if exceeding max `size_t` value.
+        \throw std::bad_alloc if allocation fails. */
+    void reserve_exact(const std::size_t more)
+    {
+      const std::size_t remaining = available();
+      if (remaining < more)
+        grow(more - remaining);
+    }
+
     /*! Copy `length` bytes starting at `ptr` to end of stream.
         \throw std::range_error If exceeding max size_t value.
         \throw std::bad_alloc If allocation fails. */
@@ -200,22 +253,30 @@
     byte_buffer take_buffer() noexcept;
   };
 
-  //! Compatability/optimization for rapidjson.
+  // definitions in byte_stream.cpp
+  extern template class basic_byte_stream<linear_growth>;
+  extern template class basic_byte_stream<geometric_growth>;
+  extern template class basic_byte_stream<hinted_growth>;
 
-  inline void PutReserve(byte_stream& dest, const std::size_t length)
+  using byte_stream = basic_byte_stream<geometric_growth>;
+
+  //! Compatability/optimization for rapidjson.
+  template<typename Growth>
+  inline void PutReserve(basic_byte_stream<Growth>& dest, const std::size_t length)
   {
     dest.reserve(length);
   }
 
   //! Compatability/optimization for rapidjson.
-
-  inline void PutUnsafe(byte_stream& dest, const std::uint8_t ch)
+  template<typename Growth>
+  inline void PutUnsafe(basic_byte_stream<Growth>& dest, const std::uint8_t ch)
   {
     dest.put_unsafe(ch);
   }
 
   //! Compability/optimization for rapidjson.
-  inline void PutN(byte_stream& dest, const std::uint8_t ch, const std::size_t count)
+  template<typename Growth>
+  inline void PutN(basic_byte_stream<Growth>& dest, const std::uint8_t ch, const std::size_t count)
   {
     dest.put_n(ch, count);
   }
@@ -37,7 +37,7 @@
 namespace
 {
   constexpr const unsigned text_size = 40;
-  constexpr const unsigned group_count = 8;
+  constexpr const unsigned group_count = display::falling_text::visible_texts();
   constexpr const unsigned color_count = 2;
   constexpr const unsigned screen_fill_percent = 60;
   constexpr const std::chrono::milliseconds text_fall_delay{80};
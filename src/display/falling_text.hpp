@@ -55,6 +55,9 @@ namespace display
   public:
     using clock = std::chrono::steady_clock;
 
+    //! \return Number of different texts on screen at once.
+    static constexpr unsigned visible_texts() noexcept { return 8; }
+
     falling_text();
 
     falling_text(const falling_text&) = delete;
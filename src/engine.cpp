@@ -29,20 +29,17 @@
 #include <thread>
 #include "engine.hpp"
 
-#include <array>
 #include <chrono>
-#include <csignal>
 #include <cstdlib>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <deque>
 #include <iostream>
-#include <map>
 #include <ncurses.h>
-#include <poll.h>
 #include <random>
 #include <string>
+#include <sys/ioctl.h>
 #include <unistd.h>
 
 #include "error.hpp"
@@ -52,17 +49,20 @@
 #include "display/falling_text.hpp"
 #include "display/sync_meter.hpp"
 #include "display/system_warning.hpp"
+#include "hash_set.hpp"
+#include "intake.hpp"
 #include "method.hpp"
 #include "pub.hpp"
+#include "reactor.hpp"
+#include "rpc/async_client.hpp"
+#include "rpc/client.hpp"
 #include "rpc/json.hpp"
+#include "rpc/json_error.hpp"
+#include "stats.hpp"
 #include "wire/json/read.hpp"
+#include "z85_cache.hpp"
 #include "zmq.hpp"
 
-//! Executes the POSIX function. \throw std::system_error on failures.
-#define POSIX_UNWRAP(...)                                      \
-  if ((__VA_ARGS__) < 0)                                       \
-    MOT_THROW(make_error_code(std::errc(errno)), #__VA_ARGS__)
-
 //! Executes the curses function. \throw std::system_error on failure.
 #define CURSES_UNWRAP(...)                                      \
   if ((__VA_ARGS__) == ERR)                                     \
@@ -77,9 +77,6 @@
     MOT_THROW(result.error(), msg);              \
   }
 
-int engine::exit_fd_{-1};
-std::atomic<bool> engine::running_{true};
-
 namespace
 {
   //! Maximum number of block hashes to keep around for "falling text" during sync
@@ -88,75 +85,87 @@ namespace
   //! Delay when showing new block "system warning"
   constexpr const std::chrono::seconds block_display_time{8};
 
-  //! ZMQ_REQ socket temporarily closed if daemon this many blocks behind
-  constexpr const std::uint64_t big_sync_interval = 5000;
-
   //! Update blockchain target height at this frequency while syncing
   constexpr const std::chrono::minutes target_sync_interval{15};
 
   //! Re-check daemon status if no pub events within this interval. Watching synced daemon should still have txpool events.
   constexpr const std::chrono::minutes no_pubs_timeout{5};
 
-  constexpr const char full_chain_topic[] = "json-full-chain_main";
-  constexpr const char minimal_chain_topic[] = "json-minimal-chain_main";
-  constexpr const char minimal_txpool_topic[] = "json-minimal-txpool_add";
+  //! Falling text hashes picked (and z85 encoded) in one batch
+  constexpr const std::size_t upcoming_text_batch = display::falling_text::visible_texts();
 
-  //! Sleeps without blocking UI.
-  void wait_for(std::chrono::milliseconds delay)
-  {
-    pollfd item[1] = {{engine::exit_fd(), POLLIN}};
-    MOT_UNWRAP(zmq::retry_op(poll, item, 1, delay.count()));
-  }
+  //! z85 text kept for the texts on screen, and the next batch
+  constexpr const std::size_t z85_cache_size = display::falling_text::visible_texts() + upcoming_text_batch;
 
-  template<std::size_t N>
-  void topic_change(void* socket, int option, const char (&topic)[N])
-  {
-    if (zmq_setsockopt(socket, option, topic, N - 1) != 0)
-      MOT_ZMQ_THROW("Subscription change failed");
-  }
+  stats::gauge txpool_bytes{"txpool.bytes"};
+  stats::gauge z85_cache_bytes{"z85_cache.bytes"};
 
-  template<std::size_t N>
-  bool matches(const byte_slice& actual, const char (&expected)[N]) noexcept
+  //! Resize ncurses to the new terminal size, after SIGWINCH.
+  void resize_terminal(reactor& events)
   {
-    return actual.size() == N - 1 && std::memcmp(actual.data(), expected, N - 1) == 0;
+    events.acknowledge_resize();
+
+    winsize size{};
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_row && size.ws_col)
+      resizeterm(size.ws_row, size.ws_col);
   }
 
-  struct base85
+  //! Sleeps without blocking UI. Returns early on SIGINT/SIGTERM.
+  void wait_for(std::chrono::milliseconds delay)
   {
-    std::array<char, 41> text;
-    bool cached;
-  };
+    reactor* const events = reactor::instance();
+    const auto deadline = reactor::clock::now() + delay;
+    for (;;)
+    {
+      const reactor::events ready = MOT_UNWRAP(events->wait({}, deadline));
+      if (ready.resize)
+        resize_terminal(*events);
+      if (ready.exit || ready.timeout)
+        break;
+    }
+  }
 
   struct motrix
   {
-    explicit motrix(const char* pub_address, const char* rpc_address) :
+    explicit motrix(const char* pub_address, const char* rpc_address, const engine::timeouts& rpc_timeouts) :
       rpc_address(rpc_address),
+      rpc_timeouts(rpc_timeouts),
       ctx(zmq_init(1)),
-      sub(),
+      pubs(ctx.get(), pub_address),
+      rpc(ctx.get(), rpc_address),
+      async_rpc(ctx.get(), rpc_address),
       daemon_height(0),
       target_height(0),
       text(),
+      encoded(z85_cache_size),
+      upcoming(),
+      txpool_hashes_rpc(true),
+      txpool_request(0),
       rand_(std::random_device{}()),
       last_block_id{}
     {
       if (!ctx)
         MOT_ZMQ_THROW("Failed to create context");
 
-      sub = zmq::connect(ctx.get(), ZMQ_SUB, pub_address);
-      if (!sub)
-        throw std::logic_error{"zmq::connect returned nullptr"};
-
       // permanently subscribed to this topic
-      topic_change(sub.get(), ZMQ_SUBSCRIBE, minimal_chain_topic);
+      MOT_UNWRAP(pubs.subscribe(intake::kMinimalChain));
+      upcoming.reserve(upcoming_text_batch);
+      z85_cache_bytes.set(encoded.memory_usage());
     }
 
     const char* rpc_address;
+    const engine::timeouts rpc_timeouts;
     const zmq::context ctx;
-    zmq::socket sub;
-    zmq::socket rpc;
+    intake pubs;
+    ::rpc::client rpc;
+    ::rpc::async_client async_rpc;
     std::uint64_t daemon_height;
     std::uint64_t target_height;
     display::falling_text text;
+    z85_cache encoded;
+    std::vector<monero::hash> upcoming; //!< Next falling text hashes, popped from back. Cleared with the hash source
+    bool txpool_hashes_rpc; //!< False if daemon lacks `get_transaction_pool_hashes`
+    unsigned txpool_request; //!< Incremented by every txpool sync
     std::mt19937 rand_;
     monero::hash last_block_id;
   };
@@ -172,101 +181,173 @@ namespace
     doupdate();
   }
 
-  void to_z85(std::array<char, 41>& out, const monero::hash& in)
+  /*! \return Next hash for falling text. A batch is picked from `hashes`
+      ahead of time, and z85 encoded in one call. */
+  template<typename T>
+  monero::hash next_text(motrix& state, const T& hashes)
   {
-    if (!zmq_z85_encode(out.data(), in.data, sizeof(in.data)))
-      throw std::runtime_error{"z85 encoding failed"};
+    if (hashes.empty())
+      return state.last_block_id; // nothing in mempool or recent block list to show
+
+    if (state.upcoming.empty())
+    {
+      // random access, so a pick is O(1) however large the txpool
+      std::uniform_int_distribution<std::size_t> dist{0, hashes.size() - 1};
+      for (std::size_t i = 0; i < upcoming_text_batch; ++i)
+        state.upcoming.push_back(hashes.begin()[dist(state.rand_)]);
+      state.encoded.prefill(to_span(state.upcoming));
+    }
+
+    const monero::hash next = state.upcoming.back();
+    state.upcoming.pop_back();
+    return next;
   }
 
+  /*! Draw falling text until decoded pub messages are queued in
+      `state.pubs`. The caller pops all of them before the next frame. Each
+      new column of text is a uniform random pick from `hashes`, a random
+      access container of `monero::hash`.
+      \return False if no pub messages arrived within `no_pubs_timeout`,
+          `ETERM` on shutdown, or other error. */
   template<typename T>
-  expect<pub::message> wait_for_pub(motrix& state, T& hashes, WINDOW* overlay)
+  expect<bool> wait_for_pubs(motrix& state, T& hashes, WINDOW* overlay)
   {
-    bool init = false;
-    typename T::iterator next;
-    std::chrono::steady_clock::duration slippage{0};
+    reactor* const events = reactor::instance();
 
     const auto start = std::chrono::steady_clock::now();
     auto now = start;
     while (engine::is_running())
     {
       if (no_pubs_timeout <= now - start)
-        return pub::message{byte_slice{}}; // hackey but both callers handle it as desired;
+        return false;
 
       if (state.text.next_fall() <= now)
       {
         while (!state.text.draw_next(now))
         {
-          if (!hashes.empty())
-          {
-            if (!init)
-            {
-              init = true;
-              std::uniform_int_distribution<std::size_t> dist{0, hashes.size()};
-              next = hashes.begin();
-              std::advance(next, dist(state.rand_));
-            }
-
-            if (next == hashes.end())
-              next = hashes.begin();
-            if (!next->second.cached)
-              to_z85(next->second.text, next->first);
-
-            next->second.cached = true;
-            state.text.add_text(next->second.text);
-          }
-          else // nothing in mempool or recent block list to show
-          {
-            std::array<char, 41> text;
-            to_z85(text, state.last_block_id);
-            state.text.add_text(text);
-          }
+          state.text.add_text(state.encoded.get(next_text(state, hashes)));
         }
       }
 
       update_screen(state, overlay);
+      if (state.pubs.ready())
+        return true;
 
       {
-        using namespace std::chrono;
-        const auto text_delay = (state.text.next_fall() - steady_clock::now()) - slippage;
-
-        zmq_pollitem_t item[1] = {{state.sub.get(), 0, ZMQ_POLLIN}};
-        if (steady_clock::duration{0} < text_delay)
-          MOT_CHECK(zmq::retry_op(zmq_poll, item, 1, duration_cast<milliseconds>(text_delay).count()));
-        else
-          item[0].revents = POLLIN;
+        // txpool is left as-is (txes from pubs only) if the request expires
+        if (state.async_rpc.pending())
+          state.async_rpc.expire();
+
+        // async RPC socket only waited on with calls in flight
+        void* const sockets[] = {
+          state.pubs.socket(), state.async_rpc.pending() ? state.async_rpc.socket() : nullptr
+        };
+
+        // absolute deadline - frame rate does not drift with processing time
+        const expect<reactor::events> ready = events->wait(sockets, state.text.next_fall());
+        if (!ready)
+          return ready.error();
+        if (ready->exit)
+          break;
+        if (ready->resize)
+        {
+          resize_terminal(*events);
+          redrawwin(state.text.handle());
+        }
 
-        if (item[0].revents & POLLIN)
+        if (ready->readable & 2)
         {
-          expect<byte_slice> event = zmq::receive(state.sub.get(), ZMQ_DONTWAIT);
-          if (event)
-            return pub::message{std::move(*event)};
-          else if (steady_clock::duration{0} < text_delay || event != zmq::make_error_code(EAGAIN))
-            return event.error();
+          const expect<std::size_t> completed = state.async_rpc.process();
+          if (!completed)
+            return completed.error();
         }
-        now = steady_clock::now();
-        slippage = (now - state.text.next_fall());
+
+        now = std::chrono::steady_clock::now();
       }
     }
     return zmq::make_error_code(ETERM);
   }
 
-  void sync_mempool(motrix& state, std::map<monero::hash, base85>& txpool)
+  using transaction_pool_rpc = rpc::json<method::get_transaction_pool>;
+  using transaction_pool_hashes_rpc = rpc::json<method::get_transaction_pool_hashes>;
+
+  /*! Fallback for daemons without `get_transaction_pool_hashes`; every tx
+      is sent in full. The reply is ignored unless `request` is still the
+      latest sync. */
+  void sync_full_mempool(motrix& state, hash_set& txpool, const unsigned request)
   {
-    txpool.clear();
+    const auto deadline = std::chrono::steady_clock::now() + state.rpc_timeouts.get_transaction_pool;
+    const expect<void> sent = state.async_rpc.try_invoke<transaction_pool_rpc>(
+      deadline,
+      [&state, &txpool, request] (expect<transaction_pool_rpc::response>&& pool)
+      {
+        if (request != state.txpool_request)
+          return; // superseded; merging would restore txes mined since
+        if (!pool)
+          return; // txpool is left as-is (txes from pubs only), same as an expired request
+
+        txpool.reserve(txpool.size() + pool->result.transactions.size());
+        for (const auto& tx : pool->result.transactions)
+          txpool.insert(tx.tx_hash);
+        txpool_bytes.set(txpool.memory_usage());
+      }
+    );
+    ETERM_CHECK(sent, "Failed to get current transaction pool");
+  }
 
-    if (!state.rpc && !(state.rpc = zmq::connect(state.ctx.get(), ZMQ_REQ, state.rpc_address)))
-      throw std::logic_error{"zmq::connect returned nullptr"};
+  /*! Request the txpool without blocking the UI; `txpool` is filled from
+      `wait_for_pubs`. Txes received via pub in the meantime are kept. Only
+      hashes are requested, unless the daemon lacked that method before.
+      Replies to earlier syncs still in flight are ignored. */
+  void sync_mempool(motrix& state, hash_set& txpool)
+  {
+    txpool.clear();
+    state.upcoming.clear();
 
-    const auto pool = zmq::invoke<rpc::json<method::get_transaction_pool>>(state.rpc.get());
-    ETERM_CHECK(pool, "Failed to get current transaction pool");
+    const unsigned request = ++state.txpool_request;
+    if (!state.txpool_hashes_rpc)
+      return sync_full_mempool(state, txpool, request);
 
-    for (const auto& tx : pool->result.transactions)
-      txpool.emplace(tx.tx_hash, base85{});
+    const auto deadline = std::chrono::steady_clock::now() + state.rpc_timeouts.get_transaction_pool;
+    const expect<void> sent = state.async_rpc.try_invoke<transaction_pool_hashes_rpc>(
+      deadline,
+      [&state, &txpool, request] (expect<transaction_pool_hashes_rpc::response>&& pool)
+      {
+        if (request != state.txpool_request)
+          return; // superseded; merging would restore txes mined since
+        if (!pool)
+        {
+          /* Only a daemon lacking the method gets the full request. A busy
+             daemon or a bad reply leaves txpool as-is (txes from pubs only),
+             and the next gap or new head asks for hashes again. */
+          if (pool.error() != rpc::json_error::method_not_found)
+            return;
+          state.txpool_hashes_rpc = false;
+          return sync_full_mempool(state, txpool, request);
+        }
 
-    state.rpc.reset();
+        hash_set& received = pool->result.tx_hashes;
+        for (const monero::hash& id : txpool)
+          received.insert(id);
+        txpool = std::move(received);
+        txpool_bytes.set(txpool.memory_usage());
+      }
+    );
+    ETERM_CHECK(sent, "Failed to get current transaction pool hashes");
   }
 
-  void show_system_warning(motrix& state, monero::hash& head_out, const monero::hash& expected_head, const std::size_t tx_count, std::map<monero::hash, base85>& txpool)
+  //! Drops pending async RPC handlers referencing objects on the stack.
+  struct cancel_async_rpc
+  {
+    rpc::async_client& client;
+
+    ~cancel_async_rpc() noexcept
+    {
+      client.cancel();
+    }
+  };
+
+  void show_system_warning(motrix& state, monero::hash& head_out, const monero::hash& expected_head, const std::size_t tx_count, hash_set& txpool)
   {
     const display::system_warning warning{state.last_block_id, state.daemon_height, tx_count};
     update_screen(state, warning.handle());
@@ -281,13 +362,15 @@ namespace
   void display_sync_progress(motrix& state)
   {
     using clock = std::chrono::steady_clock;
-    std::deque<std::pair<monero::hash, base85>> chain{};
+    std::deque<monero::hash> chain{};
+    state.upcoming.clear();
 
     // only subscribe to minimal chain while syncing, lowest overhead possible
 
     std::uint64_t target_height = 0;
     auto last_sync = clock::time_point::min();
 
+    pub::event event{};
     display::sync_meter progress{};
     progress.set_header("", "disconnected");
     update_screen(state, progress.handle());
@@ -296,10 +379,14 @@ namespace
     {
       while (!target_height || target_sync_interval <= clock::now() - last_sync)
       {
-        if (!state.rpc && !(state.rpc = zmq::connect(state.ctx.get(), ZMQ_REQ, state.rpc_address)))
-          throw std::logic_error{"Unexpected nullptr from zmq::connect"};
-
-        const auto get_info = zmq::invoke<rpc::json<method::get_info>>(state.rpc.get());
+        const auto get_info = state.rpc.invoke<rpc::json<method::get_info>>(clock::now() + state.rpc_timeouts.get_info);
+        if (get_info == common_error::kTimedOut)
+        {
+          // slow or hung daemon; connection was reset, so try again
+          progress.set_header("timeout", state.rpc_address);
+          update_screen(state, progress.handle());
+          continue;
+        }
         ETERM_CHECK(get_info, "get_info RPC failed");
         if (!get_info->result.info.outgoing_connections_count && !get_info->result.info.incoming_connections_count)
         {
@@ -307,8 +394,8 @@ namespace
           update_screen(state, progress.handle()); // before blocking call
 
           // no connections, definitely behind. wait until a block is pushed
-          const expect<void> event = zmq::wait_for(state.sub.get());
-          ETERM_CHECK(event, "sub socket failed");
+          const expect<void> received = state.pubs.wait();
+          ETERM_CHECK(received, "sub socket failed");
         }
         else
         {
@@ -326,8 +413,6 @@ namespace
             chain_type = "testnet";
 
           progress.set_header(chain_type, state.rpc_address);
-          if (target_height - state.daemon_height <= big_sync_interval)
-            state.rpc.reset();
         }
       }
 
@@ -339,23 +424,10 @@ namespace
         break;
       }
 
-      auto event = wait_for_pub(state, chain, progress.handle());
-      ETERM_CHECK(event, "Failed to read daemon pub message");
-
-      if (matches(event->topic, minimal_chain_topic))
-      {
-        const auto block = wire::json::from_bytes<pub::minimal_chain>(std::move(event->contents));
-        if (block.ids.empty())
-          throw std::runtime_error{"Chain missing ids"};
+      const expect<bool> received = wait_for_pubs(state, chain, progress.handle());
+      ETERM_CHECK(received, "Failed to read daemon pub message");
 
-        state.daemon_height = block.first_height;
-        state.last_block_id = block.ids.back();
-        if (max_block_hash_buffer <= chain.size())
-          chain.pop_front();
-
-        chain.emplace_back(state.last_block_id, base85{});
-      }
-      else if (event->topic.empty() && event->contents.empty())
+      if (!*received)
       {
         /* No block events in a while, recheck daemon status. Value does not get
            displayed to user until a `progress.set_progress(...)` call. */
@@ -363,15 +435,39 @@ namespace
         progress.set_header("", "disconnected");
         update_screen(state, progress.handle());
       }
+
+      // txpool and full chain events can be left over from `display_txpool`
+      while (state.pubs.try_pop(event))
+      {
+        if (event.type == pub::event::kind::minimal_chain)
+        {
+          const pub::minimal_chain& block = event.chain;
+          if (block.ids.empty())
+            throw std::runtime_error{"Chain missing ids"};
+
+          state.daemon_height = block.first_height;
+          state.last_block_id = block.ids.back();
+          if (max_block_hash_buffer <= chain.size())
+            chain.pop_front();
+
+          chain.push_back(state.last_block_id);
+        }
+      }
     }
   }
 
   void display_txpool(motrix& state)
   {
-    std::map<monero::hash, base85> txpool{};
+    hash_set txpool{};
+    pub::event event{};
+    const cancel_async_rpc cancel_txpool{state.async_rpc};
 
-    topic_change(state.sub.get(), ZMQ_SUBSCRIBE, full_chain_topic);
-    topic_change(state.sub.get(), ZMQ_SUBSCRIBE, minimal_txpool_topic);
+    {
+      const expect<void> subscribed = state.pubs.subscribe(
+        intake::kMinimalChain | intake::kFullChain | intake::kMinimalTxpool
+      );
+      ETERM_CHECK(subscribed, "Subscription change failed");
+    }
     sync_mempool(state, txpool);
 
     unsigned last_txs_count = 0;
@@ -385,66 +481,73 @@ namespace
 
     while (engine::is_running())
     {
-      auto event = wait_for_pub(state, txpool, nullptr);
-      ETERM_CHECK(event, "Failed to read daemon pub message");
+      const expect<bool> received = wait_for_pubs(state, txpool, nullptr);
+      ETERM_CHECK(received, "Failed to read daemon pub message");
+      if (!*received)
+        break; // no events (no txpool nor chain) in a while, re-check daemon status
 
-      if (matches(event->topic, minimal_chain_topic))
-      {
-        const auto minimal_block = wire::json::from_bytes<pub::minimal_chain>(std::move(event->contents));
-        if (minimal_block.ids.empty())
-          throw std::runtime_error{"bad block ids"};
-
-        const bool reorg = minimal_block.first_height < state.daemon_height;
-        state.daemon_height = minimal_block.first_height;
-        if (reorg)
-          break; // re-check daemon status
-
-        const bool gap = (state.last_block_id != minimal_block.first_prev_id);
-        state.last_block_id = minimal_block.ids.back();
-        minimal_block_prev = minimal_block.ids.size() == 1 ?
-          minimal_block.first_prev_id : minimal_block.ids.at(minimal_block.ids.size() - 2);
-
-        if (gap)
-          sync_mempool(state, txpool);
-
-        // full block pub received
-        if (full_block_prev == minimal_block.first_prev_id)
-          show_system_warning(state, current_head, full_block_prev, last_txs_count, txpool);
-      }
-      else if (matches(event->topic, full_chain_topic))
+      // every queued message is applied before the next frame is drawn
+      bool resync = false;
+      while (state.pubs.try_pop(event))
       {
-        const auto full_blocks = wire::json::from_bytes<pub::full_chain>(std::move(event->contents));
-        if (full_blocks.empty())
-          throw std::runtime_error{"empty full-chain_main"};
-
-        last_txs_count = full_blocks.back().tx_hashes.size();
-        full_block_prev = full_blocks.back().prev_id;
-        for (const monero::block& bl : full_blocks)
+        if (event.type == pub::event::kind::minimal_chain)
         {
-          for (const monero::hash& hash : bl.tx_hashes)
-            txpool.erase(hash);
+          const pub::minimal_chain& minimal_block = event.chain;
+          if (minimal_block.ids.empty())
+            throw std::runtime_error{"bad block ids"};
+
+          const bool reorg = minimal_block.first_height < state.daemon_height;
+          state.daemon_height = minimal_block.first_height;
+          if (reorg)
+          {
+            resync = true; // re-check daemon status
+            break;
+          }
+
+          const bool gap = (state.last_block_id != minimal_block.first_prev_id);
+          state.last_block_id = minimal_block.ids.back();
+          minimal_block_prev = minimal_block.ids.size() == 1 ?
+            minimal_block.first_prev_id : minimal_block.ids.at(minimal_block.ids.size() - 2);
+
+          if (gap)
+            sync_mempool(state, txpool);
+
+          // full block pub received
+          if (full_block_prev == minimal_block.first_prev_id)
+            show_system_warning(state, current_head, full_block_prev, last_txs_count, txpool);
         }
+        else if (event.type == pub::event::kind::full_chain)
+        {
+          const pub::full_chain& full_blocks = event.blocks;
+          if (!full_blocks.blocks)
+            throw std::runtime_error{"empty full-chain_main"};
 
-        // minimal block pub received
-        if (minimal_block_prev == full_blocks.back().prev_id)
-          show_system_warning(state, current_head, full_block_prev, last_txs_count, txpool);
-      }
-      else if (matches(event->topic, minimal_txpool_topic))
-      {
-        const auto daemon_pool = wire::json::from_bytes<pub::minimal_txpool>(std::move(event->contents));
-        for (const monero::minimal_tx& tx : daemon_pool)
-          txpool.emplace(tx.id, base85{});
+          last_txs_count = full_blocks.last_tx_count;
+          full_block_prev = full_blocks.last_prev_id;
+          txpool.erase_all(to_span(full_blocks.tx_hashes));
+
+          // minimal block pub received
+          if (minimal_block_prev == full_blocks.last_prev_id)
+            show_system_warning(state, current_head, full_block_prev, last_txs_count, txpool);
+        }
+        else if (event.type == pub::event::kind::minimal_txpool)
+        {
+          for (const monero::minimal_tx& tx : event.txpool)
+            txpool.insert(tx.id);
+        }
       }
-      else if (event->topic.empty() && event->contents.empty())
-        break; // no events (no txpool nor chain) in a while, re-check daemon status
+      txpool_bytes.set(txpool.memory_usage());
+
+      if (resync)
+        break;
     }
 
-    topic_change(state.sub.get(), ZMQ_UNSUBSCRIBE, minimal_txpool_topic);
-    topic_change(state.sub.get(), ZMQ_UNSUBSCRIBE, full_chain_topic);
+    const expect<void> unsubscribed = state.pubs.subscribe(intake::kMinimalChain);
+    ETERM_CHECK(unsubscribed, "Subscription change failed");
   }
 }
 
-void engine::run(const char* pub_address, const char* rpc_address, const char* color_scheme)
+void engine::run(const char* pub_address, const char* rpc_address, const char* color_scheme, const timeouts& rpc_timeouts)
 {
   if (!rpc_address || !pub_address)
     throw std::logic_error{"engine::run given nullptr address"};
@@ -452,19 +555,8 @@ void engine::run(const char* pub_address, const char* rpc_address, const char* c
   initscr();
   display::exit cleanup{};
 
-  {
-    int exit_pipe[2] = {-1, -1};
-    POSIX_UNWRAP(pipe(exit_pipe));
-    exit_fd_ = exit_pipe[0];
-
-    static const int signal_exit = exit_pipe[1];
-    std::signal(SIGINT, [](int)
-    {
-      running_ = false;
-      if (::write(signal_exit, "\0", 1) != 1)
-        std::abort();
-    });
-  }
+  // before `zmq_init`, so ZMQ threads inherit the signal mask
+  reactor events{};
 
   cbreak();
   noecho();
@@ -501,7 +593,7 @@ void engine::run(const char* pub_address, const char* rpc_address, const char* c
   else
     throw std::runtime_error{color_scheme + std::string{"is not a valid color scheme argument"}};
 
-  motrix state{pub_address, rpc_address};
+  motrix state{pub_address, rpc_address, rpc_timeouts};
   while (engine::is_running())
   {
     display_sync_progress(state);
@@ -29,18 +29,23 @@
 #ifndef MONRIX_ENGINE_HPP
 #define MONRIX_ENGINE_HPP
 
-#include <atomic>
+#include <chrono>
+
+#include "reactor.hpp"
 
 class engine
 {
-  static int exit_fd_;
-  static std::atomic<bool> running_;
-
 public:
-  static void run(const char* pub_address, const char* rpc_address, const char* color_scheme);
+  //! Maximum time to wait for each daemon RPC response.
+  struct timeouts
+  {
+    std::chrono::milliseconds get_info;
+    std::chrono::milliseconds get_transaction_pool;
+  };
+
+  static void run(const char* pub_address, const char* rpc_address, const char* color_scheme, const timeouts& rpc_timeouts);
 
-  static int exit_fd() noexcept { return exit_fd_; }
-  static bool is_running() noexcept { return running_; }
+  static bool is_running() noexcept { return !reactor::exit_requested(); }
 };
 
 #endif // MONRIX_ENGINE_HPP
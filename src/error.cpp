@@ -45,6 +45,8 @@ namespace
                     return make_error_code(std::errc::invalid_argument).message();
                 case common_error::kInvalidErrorCode:
                     return "expect<T> was given an error value of zero";
+                case common_error::kTimedOut:
+                    return "Deadline expired before operation completed";
                 default:
                     break;
             }
@@ -59,6 +61,8 @@ namespace
                 case common_error::kInvalidArgument:
                 case common_error::kInvalidErrorCode:
                     return std::errc::invalid_argument;
+                case common_error::kTimedOut:
+                    return std::errc::timed_out;
                 default:
                     break;
             }
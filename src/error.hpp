@@ -33,7 +33,8 @@ enum class common_error : int
 {
     // 0 is reserved for no error, as per expect<T>
     kInvalidArgument = 1, //!< A function argument is invalid
-    kInvalidErrorCode     //!< Default `std::error_code` given to `expect<T>`
+    kInvalidErrorCode,    //!< Default `std::error_code` given to `expect<T>`
+    kTimedOut             //!< Deadline expired before operation completed
 };
 
 std::error_category const& common_category() noexcept;
@@ -0,0 +1,270 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOTRIX_HASH_SET_HPP
+#define MOTRIX_HASH_SET_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+#include "monero_data.hpp"
+#include "span.hpp"
+#include "wire/json/fwd.hpp"
+
+/*! \brief Flat open-addressing set of `monero::hash`, with hashes kept
+    densely for O(1) random selection.
+
+    Hashes are stored contiguously in a cache-line aligned array (2 per
+    line, never split), and a separate table of slots holds the index of
+    each hash. Hashes are uniformly random, so the first 8 bytes select the
+    slot directly. Collisions are resolved with linear probing, and erasing
+    shifts the rest of the probe run back (no tombstones), so lookups never
+    slow down as txes come and go. An erased hash is replaced by the last
+    hash, so every operation is O(1) and iterators are random access -
+    `begin()[n]` for a uniform random `n` picks a uniform random hash.
+    Capacity is kept after `erase` and `clear`.
+
+    Any insert or erase invalidates iterators. */
+class hash_set
+{
+public:
+  using value_type = monero::hash;
+  using iterator = const monero::hash*;
+
+  //! Alignment of the dense hash array.
+  static constexpr const std::size_t cache_line = 64;
+
+private:
+  static constexpr const std::size_t min_capacity = 16;
+
+  struct release_hashes
+  {
+    void operator()(monero::hash* ptr) const noexcept { std::free(ptr); }
+  };
+
+  std::unique_ptr<monero::hash, release_hashes> hashes_;
+  std::unique_ptr<std::uint32_t[]> slots_; //!< Index + 1 into `hashes_`, or 0 if empty
+  std::size_t size_;
+  std::size_t capacity_; //!< Of `hashes_`
+  std::size_t mask_; //!< Slot count - 1, or 0 without `slots_`
+
+  std::size_t home(const monero::hash& key) const noexcept
+  {
+    std::uint64_t prefix = 0;
+    std::memcpy(std::addressof(prefix), key.data, sizeof(prefix));
+    return std::size_t(prefix) & mask_;
+  }
+
+  //! \return Slot of `key`, or empty slot ending its probe run. \pre `slots_`.
+  std::size_t probe(const monero::hash& key) const noexcept
+  {
+    std::size_t index = home(key);
+    while (slots_[index] && hashes_.get()[slots_[index] - 1] != key)
+      index = (index + 1) & mask_;
+    return index;
+  }
+
+  //! Move hashes to a new array of `capacity`.
+  void reallocate(const std::size_t capacity)
+  {
+    void* memory = nullptr;
+    if (posix_memalign(std::addressof(memory), cache_line, capacity * sizeof(monero::hash)))
+      throw std::bad_alloc{};
+
+    std::unique_ptr<monero::hash, release_hashes> hashes{static_cast<monero::hash*>(memory)};
+    if (size_)
+      std::memcpy(hashes.get(), hashes_.get(), size_ * sizeof(monero::hash));
+    hashes_ = std::move(hashes);
+    capacity_ = capacity;
+  }
+
+  //! Re-index every hash into `capacity` slots (power of 2).
+  void rehash(const std::size_t capacity)
+  {
+    slots_.reset(new std::uint32_t[capacity]());
+    mask_ = capacity - 1;
+    for (std::size_t i = 0; i < size_; ++i)
+      slots_[probe(hashes_.get()[i])] = std::uint32_t(i + 1);
+  }
+
+  //! Remove hash of slot `index`, and shift back later slots of the probe run.
+  void erase_slot(const std::size_t index) noexcept
+  {
+    monero::hash* const hashes = hashes_.get();
+    const std::size_t removed = slots_[index] - 1;
+
+    std::size_t hole = index;
+    for (std::size_t next = (index + 1) & mask_; slots_[next]; next = (next + 1) & mask_)
+    {
+      // move `next` unless the hole precedes its home slot in the run
+      const std::size_t distance = (next - home(hashes[slots_[next] - 1])) & mask_;
+      if (((next - hole) & mask_) <= distance)
+      {
+        slots_[hole] = slots_[next];
+        hole = next;
+      }
+    }
+    slots_[hole] = 0;
+
+    // fill the gap in `hashes_` with the last hash
+    --size_;
+    if (removed != size_)
+    {
+      slots_[probe(hashes[size_])] = std::uint32_t(removed + 1);
+      hashes[removed] = hashes[size_];
+    }
+  }
+
+public:
+  hash_set() noexcept
+    : hashes_(), slots_(), size_(0), capacity_(0), mask_(0)
+  {}
+
+  //! `rhs` is left empty, without storage.
+  hash_set(hash_set&& rhs) noexcept
+    : hash_set()
+  {
+    swap(rhs);
+  }
+
+  //! `rhs` is left empty, without storage.
+  hash_set& operator=(hash_set&& rhs) noexcept
+  {
+    hash_set temp{std::move(rhs)};
+    swap(temp);
+    return *this;
+  }
+
+  void swap(hash_set& rhs) noexcept
+  {
+    using std::swap;
+    swap(hashes_, rhs.hashes_);
+    swap(slots_, rhs.slots_);
+    swap(size_, rhs.size_);
+    swap(capacity_, rhs.capacity_);
+    swap(mask_, rhs.mask_);
+  }
+
+  bool empty() const noexcept { return size_ == 0; }
+  std::size_t size() const noexcept { return size_; }
+
+  iterator begin() const noexcept { return hashes_.get(); }
+  iterator end() const noexcept { return begin() + size_; }
+
+  //! \return Bytes allocated by `this`, for memory accounting.
+  std::size_t memory_usage() const noexcept
+  {
+    return capacity_ * sizeof(monero::hash) + (slots_ ? (mask_ + 1) * sizeof(std::uint32_t) : 0);
+  }
+
+  /*! Grow so that `count` hashes fit without another allocation.
+    \throw std::length_error if `count` does not fit in 32-bit indexes. */
+  void reserve(const std::size_t count)
+  {
+    if (std::numeric_limits<std::uint32_t>::max() < count)
+      throw std::length_error{"hash_set exceeded 32-bit indexes"};
+
+    if (capacity_ < count)
+    {
+      const std::size_t capacity = capacity_ ? capacity_ * 2 : std::size_t(min_capacity);
+      reallocate(count < capacity ? capacity : count);
+    }
+
+    std::size_t slots = slots_ ? mask_ + 1 : min_capacity;
+    while (slots / 2 < count) // at most half full
+      slots *= 2;
+    if (!slots_ || mask_ + 1 < slots)
+      rehash(slots);
+  }
+
+  //! Add `key` unless present. \return True if added.
+  bool insert(const monero::hash& key)
+  {
+    reserve(size_ + 1);
+    const std::size_t index = probe(key);
+    if (slots_[index])
+      return false;
+
+    hashes_.get()[size_] = key;
+    slots_[index] = std::uint32_t(++size_);
+    return true;
+  }
+
+  bool contains(const monero::hash& key) const noexcept
+  {
+    return !empty() && slots_[probe(key)];
+  }
+
+  //! \return Number of hashes removed (0 or 1).
+  std::size_t erase(const monero::hash& key) noexcept
+  {
+    if (empty())
+      return 0;
+    const std::size_t index = probe(key);
+    if (!slots_[index])
+      return 0;
+    erase_slot(index);
+    return 1;
+  }
+
+  //! Remove every hash in `keys`, i.e. txes mined in a block. \return Number removed.
+  std::size_t erase_all(const span<const monero::hash> keys) noexcept
+  {
+    const std::size_t original = size_;
+    for (const monero::hash& key : keys)
+    {
+      if (empty())
+        break;
+      const std::size_t index = probe(key);
+      if (slots_[index])
+        erase_slot(index);
+    }
+    return original - size_;
+  }
+
+  //! Remove every hash; capacity is kept.
+  void clear() noexcept
+  {
+    size_ = 0;
+    if (slots_)
+      std::fill(slots_.get(), slots_.get() + mask_ + 1, std::uint32_t(0));
+  }
+};
+
+//! Replace `dest` with the hashes in a JSON array, without an intermediate copy.
+void read_bytes(wire::json_reader& source, hash_set& dest);
+
+#endif // MOTRIX_HASH_SET_HPP
@@ -31,6 +31,11 @@
 #include <limits>
 #include "ascii_table.hpp"
 
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+  #define MOTRIX_HEX_X86 1
+  #include <immintrin.h>
+#endif
+
   namespace
   {
     template<typename T>
@@ -46,11 +51,193 @@
         ++out;
       }
     }
+
+    //! `length` is the number of bytes in `src`.
+    void encode_scalar(char* out, const std::uint8_t* src, const std::size_t length) noexcept
+    {
+      write_hex(out, {src, length});
+    }
+
+    //! `length` is the number of hex characters in `src`, and must be even.
+    bool decode_scalar(std::uint8_t* dst, const unsigned char* src, const std::size_t length) noexcept
+    {
+      for(size_t i = 0; i < length; i += 2)
+      {
+        int tmp = *src++;
+        tmp = ascii::isx[tmp];
+        if (tmp == 0xff) return false;
+        int t2 = *src++;
+        t2 = ascii::isx[t2];
+        if (t2 == 0xff) return false;
+        *dst++ = (tmp << 4) | t2;
+      }
+      return true;
+    }
+
+    struct hex_kernels
+    {
+      void (*encode)(char*, const std::uint8_t*, std::size_t);
+      bool (*decode)(std::uint8_t*, const unsigned char*, std::size_t);
+    };
+
+#ifdef MOTRIX_HEX_X86
+    /* Each kernel is compiled for its instruction set with a `target`
+       attribute, so the rest of the binary keeps the baseline ISA. The
+       remainder shorter than one vector goes through the scalar code. */
+
+    //! \return Hex characters ('0'-'9', 'a'-'f') for nibbles in `value`.
+    __attribute__((target("sse2")))
+    inline __m128i nibbles_to_hex(const __m128i value) noexcept
+    {
+      const __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(value, _mm_set1_epi8(9)), _mm_set1_epi8('a' - '0' - 10));
+      return _mm_add_epi8(_mm_add_epi8(value, _mm_set1_epi8('0')), letters);
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256i nibbles_to_hex(const __m256i value) noexcept
+    {
+      const __m256i letters = _mm256_and_si256(_mm256_cmpgt_epi8(value, _mm256_set1_epi8(9)), _mm256_set1_epi8('a' - '0' - 10));
+      return _mm256_add_epi8(_mm256_add_epi8(value, _mm256_set1_epi8('0')), letters);
+    }
+
+    /*! \return Nibble for each hex character in `chars`, and sets `valid` to
+        0xFF in lanes that were '0'-'9', 'a'-'f', or 'A'-'F'. Comparisons are
+        signed, so bytes >= 0x80 are never valid. */
+    __attribute__((target("sse2")))
+    inline __m128i hex_to_nibbles(const __m128i chars, __m128i& valid) noexcept
+    {
+      const __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+      const __m128i digit = _mm_and_si128(
+        _mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), chars)
+      );
+      const __m128i letter = _mm_and_si128(
+        _mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('f' + 1), lower)
+      );
+      valid = _mm_or_si128(digit, letter);
+      return _mm_or_si128(
+        _mm_and_si128(digit, _mm_sub_epi8(chars, _mm_set1_epi8('0'))),
+        _mm_and_si128(letter, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10)))
+      );
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256i hex_to_nibbles(const __m256i chars, __m256i& valid) noexcept
+    {
+      const __m256i lower = _mm256_or_si256(chars, _mm256_set1_epi8(0x20));
+      const __m256i digit = _mm256_and_si256(
+        _mm256_cmpgt_epi8(chars, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chars)
+      );
+      const __m256i letter = _mm256_and_si256(
+        _mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), lower)
+      );
+      valid = _mm256_or_si256(digit, letter);
+      return _mm256_or_si256(
+        _mm256_and_si256(digit, _mm256_sub_epi8(chars, _mm256_set1_epi8('0'))),
+        _mm256_and_si256(letter, _mm256_sub_epi8(lower, _mm256_set1_epi8('a' - 10)))
+      );
+    }
+
+    //! 8 bytes to 16 characters per iteration.
+    __attribute__((target("sse2")))
+    void encode_sse2(char* out, const std::uint8_t* src, const std::size_t length) noexcept
+    {
+      std::size_t i = 0;
+      for (; 8 <= length - i; i += 8)
+      {
+        const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), _mm_set1_epi8(0x0F));
+        const __m128i low = _mm_and_si128(bytes, _mm_set1_epi8(0x0F));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2), nibbles_to_hex(_mm_unpacklo_epi8(high, low)));
+      }
+      encode_scalar(out + i * 2, src + i, length - i);
+    }
+
+    //! 16 bytes to 32 characters per iteration.
+    __attribute__((target("avx2")))
+    void encode_avx2(char* out, const std::uint8_t* src, const std::size_t length) noexcept
+    {
+      std::size_t i = 0;
+      for (; 16 <= length - i; i += 16)
+      {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), _mm_set1_epi8(0x0F));
+        const __m128i low = _mm_and_si128(bytes, _mm_set1_epi8(0x0F));
+        const __m256i nibbles = _mm256_inserti128_si256(
+          _mm256_castsi128_si256(_mm_unpacklo_epi8(high, low)), _mm_unpackhi_epi8(high, low), 1
+        );
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * 2), nibbles_to_hex(nibbles));
+      }
+      encode_sse2(out + i * 2, src + i, length - i);
+    }
+
+    //! 16 characters to 8 bytes per iteration.
+    __attribute__((target("sse2")))
+    bool decode_sse2(std::uint8_t* dst, const unsigned char* src, const std::size_t length) noexcept
+    {
+      std::size_t i = 0;
+      for (; 16 <= length - i; i += 16)
+      {
+        __m128i valid;
+        const __m128i nibbles = hex_to_nibbles(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), valid);
+        if (_mm_movemask_epi8(valid) != 0xFFFF)
+          return false;
+
+        // little endian 16-bit lanes: high nibble in low byte, low nibble in high byte
+        const __m128i bytes = _mm_or_si128(
+          _mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0x00FF)), 4), _mm_srli_epi16(nibbles, 8)
+        );
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i / 2), _mm_packus_epi16(bytes, bytes));
+      }
+      return decode_scalar(dst + i / 2, src + i, length - i);
+    }
+
+    //! 32 characters to 16 bytes per iteration.
+    __attribute__((target("avx2")))
+    bool decode_avx2(std::uint8_t* dst, const unsigned char* src, const std::size_t length) noexcept
+    {
+      std::size_t i = 0;
+      for (; 32 <= length - i; i += 32)
+      {
+        __m256i valid;
+        const __m256i nibbles = hex_to_nibbles(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)), valid);
+        if (unsigned(_mm256_movemask_epi8(valid)) != 0xFFFFFFFFu)
+          return false;
+
+        const __m256i bytes = _mm256_or_si256(
+          _mm256_slli_epi16(_mm256_and_si256(nibbles, _mm256_set1_epi16(0x00FF)), 4), _mm256_srli_epi16(nibbles, 8)
+        );
+
+        // pack works within 128-bit lanes; move both 8 byte results together
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(bytes, bytes), 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i / 2), _mm256_castsi256_si128(packed));
+      }
+      return decode_sse2(dst + i / 2, src + i, length - i);
+    }
+#endif // MOTRIX_HEX_X86
+
+    hex_kernels select_kernels() noexcept
+    {
+#ifdef MOTRIX_HEX_X86
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx2"))
+        return {encode_avx2, decode_avx2};
+      if (__builtin_cpu_supports("sse2"))
+        return {encode_sse2, decode_sse2};
+#endif
+      return {encode_scalar, decode_scalar};
+    }
+
+    //! \return Fastest kernels supported by the CPU, chosen once.
+    const hex_kernels& kernels() noexcept
+    {
+      static const hex_kernels selected = select_kernels();
+      return selected;
+    }
   }
 
   void to_hex::buffer_unchecked(char* out, const span<const std::uint8_t> src) noexcept
   {
-    return write_hex(out, src);
+    kernels().encode(out, src.data(), src.size());
   }
 
   bool from_hex::to_buffer(span<std::uint8_t> out, const span<const char> src) noexcept
@@ -64,18 +251,5 @@
   {
       if (s.size() % 2 != 0)
         return false;
-
-      const unsigned char *src = (const unsigned char *)s.data();
-      for(size_t i = 0; i < s.size(); i += 2)
-      {
-        int tmp = *src++;
-        tmp = ascii::isx[tmp];
-        if (tmp == 0xff) return false;
-        int t2 = *src++;
-        t2 = ascii::isx[t2];
-        if (t2 == 0xff) return false;
-        *dst++ = (tmp << 4) | t2;
-      }
-
-      return true;
+      return kernels().decode(dst, reinterpret_cast<const unsigned char*>(s.data()), s.size());
   }
@@ -0,0 +1,311 @@
+// Copyright (c) 2020, Lee Clagett
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "intake.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+#include "stats.hpp"
+#include "wire/json/read.hpp"
+
+namespace
+{
+  constexpr const char notify_address[] = "inproc://motrix-intake";
+
+  constexpr const char full_chain_topic[] = "json-full-chain_main";
+  constexpr const char minimal_chain_topic[] = "json-minimal-chain_main";
+  constexpr const char minimal_txpool_topic[] = "json-minimal-txpool_add";
+
+  //! Maximum time spent draining queued pub messages before waking the render thread
+  constexpr const std::chrono::milliseconds drain_budget{5};
+
+  namespace stat
+  {
+    stats::counter pub_batches{"pub.batches"};
+    stats::counter pub_messages{"pub.messages"};
+    stats::counter pub_budget_exceeded{"pub.budget_exceeded"}; //!< Batches stopped by `drain_budget` with messages still queued
+    stats::counter pub_malformed{"pub.malformed"}; //!< Messages dropped because they failed to decode
+    stats::gauge pub_batch_size{"pub.batch_size"}; //!< Messages decoded in the last batch
+    stats::counter ring_full{"intake.ring_full"};
+    stats::gauge queued{"intake.queued"}; //!< Decoded messages waiting when the render thread wakes
+  }
+
+  template<std::size_t N>
+  void topic_change(void* socket, int option, const char (&topic)[N])
+  {
+    if (zmq_setsockopt(socket, option, topic, N - 1) != 0)
+      MOT_ZMQ_THROW("Subscription change failed");
+  }
+
+  template<std::size_t N>
+  bool matches(const byte_slice& actual, const char (&expected)[N]) noexcept
+  {
+    return actual.size() == N - 1 && std::memcmp(actual.data(), expected, N - 1) == 0;
+  }
+
+  zmq::socket make_pair(void* ctx)
+  {
+    zmq::socket out{zmq_socket(ctx, ZMQ_PAIR)};
+    if (!out)
+      MOT_ZMQ_THROW("Failed to create socket");
+
+    int linger = 0;
+    if (zmq_setsockopt(out.get(), ZMQ_LINGER, &linger, sizeof(linger)) != 0)
+      MOT_ZMQ_THROW("Failed to set ZMQ linger option");
+    return out;
+  }
+
+  //! \return True if `socket` has a message ready to read. False on error.
+  bool is_readable(void* socket) noexcept
+  {
+    int events = 0;
+    std::size_t length = sizeof(events);
+    return zmq_getsockopt(socket, ZMQ_EVENTS, &events, &length) == 0 && (events & ZMQ_POLLIN);
+  }
+
+  //! \return False if `result` is an error, which is counted and dropped.
+  bool decoded(const expect<void>& result) noexcept
+  {
+    if (!result)
+    {
+      stat::pub_malformed.increment();
+      return false;
+    }
+    return true;
+  }
+
+  /*! Decodes straight into `out`, so the buffers of the slot (returned by
+      `try_pop`) and of `reader` are re-used. Malformed messages are dropped
+      instead of stopping intake; a misbehaving publisher costs no more than
+      a valid message.
+      \return False if `message` has an unknown topic or is malformed. */
+  bool decode(pub::event& out, pub::message& message, wire::json_reader& reader)
+  {
+    if (matches(message.topic, minimal_chain_topic))
+    {
+      out.type = pub::event::kind::minimal_chain;
+      return decoded(wire::json::try_from_bytes(std::move(message.contents), out.chain, reader));
+    }
+    else if (matches(message.topic, full_chain_topic))
+    {
+      out.type = pub::event::kind::full_chain;
+      return decoded(wire::json::try_from_bytes(std::move(message.contents), out.blocks, reader));
+    }
+    else if (matches(message.topic, minimal_txpool_topic))
+    {
+      out.type = pub::event::kind::minimal_txpool;
+      return decoded(wire::json::try_from_bytes(std::move(message.contents), out.txpool, reader));
+    }
+    return false;
+  }
+}
+
+void intake::run() noexcept
+{
+  try
+  {
+    unsigned subscribed = 0;
+    for (;;)
+    {
+      /* Only the pair socket is checked while the ring is full. `waiting_`
+         is set before the ring is checked again, so either that check sees
+         room, or the `try_pop` that made room sees `waiting_` and sends a
+         wake-up. */
+      bool full = (events_.back() == nullptr);
+      if (full)
+      {
+        waiting_.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        full = (events_.back() == nullptr);
+        if (!full)
+          waiting_.store(false, std::memory_order_relaxed);
+      }
+      zmq_pollitem_t items[2] = {{worker_.get(), 0, ZMQ_POLLIN, 0}, {sub_.get(), 0, ZMQ_POLLIN, 0}};
+      MOT_UNWRAP(zmq::retry_op(zmq_poll, items, full ? 1 : 2, -1));
+
+      if (items[0].revents & ZMQ_POLLIN)
+      {
+        for (;;)
+        {
+          unsigned topics = 0;
+          const int read = zmq_recv(worker_.get(), &topics, sizeof(topics), ZMQ_DONTWAIT);
+          if (read < 0)
+          {
+            if (zmq_errno() == EAGAIN)
+              break;
+            MOT_ZMQ_THROW("Failed to read intake command");
+          }
+          if (read == 0)
+            return; // empty message is stop request
+          if (read == 1)
+            continue; // room in ring; `full` is checked again
+          if (read != sizeof(topics))
+            throw std::logic_error{"Invalid intake command"};
+
+          const unsigned changed = topics ^ subscribed;
+          if (changed & kMinimalChain)
+            topic_change(sub_.get(), (topics & kMinimalChain) ? ZMQ_SUBSCRIBE : ZMQ_UNSUBSCRIBE, minimal_chain_topic);
+          if (changed & kFullChain)
+            topic_change(sub_.get(), (topics & kFullChain) ? ZMQ_SUBSCRIBE : ZMQ_UNSUBSCRIBE, full_chain_topic);
+          if (changed & kMinimalTxpool)
+            topic_change(sub_.get(), (topics & kMinimalTxpool) ? ZMQ_SUBSCRIBE : ZMQ_UNSUBSCRIBE, minimal_txpool_topic);
+          subscribed = topics;
+        }
+      }
+
+      if (!full && (items[1].revents & ZMQ_POLLIN))
+        MOT_UNWRAP(drain());
+    }
+  }
+  catch (...)
+  {
+    error_ = std::current_exception();
+    failed_.store(true, std::memory_order_release);
+    zmq_send(worker_.get(), nullptr, 0, ZMQ_DONTWAIT);
+  }
+}
+
+expect<void> intake::drain()
+{
+  const auto budget = std::chrono::steady_clock::now() + drain_budget;
+  const wire::json_context reader{};
+
+  std::size_t count = 0;
+  for (pub::event* slot = events_.back(); slot; slot = events_.back())
+  {
+    expect<byte_rope> raw = zmq::receive_segments(sub_.get(), ZMQ_DONTWAIT);
+    if (!raw)
+    {
+      if (raw == zmq::make_error_code(EAGAIN))
+        break;
+      return raw.error();
+    }
+
+    pub::message message{std::move(*raw)};
+    if (decode(*slot, message, *reader))
+    {
+      events_.push();
+      ++count;
+    }
+
+    // malformed messages count against the budget too
+    if (budget <= std::chrono::steady_clock::now())
+    {
+      if (is_readable(sub_.get()))
+        stat::pub_budget_exceeded.increment();
+      break;
+    }
+  }
+
+  if (!events_.back())
+    stat::ring_full.increment();
+
+  if (count)
+  {
+    stat::pub_batches.increment();
+    stat::pub_messages.add(count);
+    stat::pub_batch_size.set(count);
+
+    // if the pair is full, a wake-up is already pending
+    if (zmq_send(worker_.get(), nullptr, 0, ZMQ_DONTWAIT) < 0 && zmq_errno() != EAGAIN)
+      return zmq::get_error_code();
+  }
+  return success();
+}
+
+intake::intake(void* ctx, const char* pub_address)
+  : events_(capacity),
+    sub_(zmq::connect(ctx, ZMQ_SUB, pub_address)),
+    notify_(make_pair(ctx)),
+    worker_(make_pair(ctx)),
+    error_(),
+    failed_(false),
+    waiting_(false),
+    thread_()
+{
+  if (zmq_bind(worker_.get(), notify_address) != 0)
+    MOT_ZMQ_THROW("Failed to bind intake socket");
+  if (zmq_connect(notify_.get(), notify_address) != 0)
+    MOT_ZMQ_THROW("Failed to connect intake socket");
+
+  thread_ = std::thread{&intake::run, this};
+}
+
+intake::~intake() noexcept
+{
+  if (thread_.joinable())
+  {
+    // empty message is stop request; sockets are closed after the join
+    zmq_send(notify_.get(), nullptr, 0, 0);
+    thread_.join();
+  }
+}
+
+expect<void> intake::subscribe(const unsigned topics)
+{
+  MOT_ZMQ_CHECK(zmq_send(notify_.get(), &topics, sizeof(topics), 0));
+  return success();
+}
+
+bool intake::ready() noexcept
+{
+  // any event pushed after this loop sends another wake-up
+  while (0 <= zmq_recv(notify_.get(), nullptr, 0, ZMQ_DONTWAIT))
+    ;
+  stat::queued.set(events_.size()); // backlog depth, before the caller pops
+  return !events_.empty() || failed_.load(std::memory_order_acquire);
+}
+
+expect<void> intake::wait()
+{
+  while (!ready())
+    MOT_CHECK(zmq::wait_for(notify_.get()));
+  return success();
+}
+
+bool intake::try_pop(pub::event& out)
+{
+  if (events_.try_pop(out))
+  {
+    // pairs with the fence in `run`; the pop is visible before `waiting_` is read
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting_.load(std::memory_order_relaxed) && waiting_.exchange(false, std::memory_order_relaxed))
+    {
+      // if the pair is full, a wake-up is already pending
+      static constexpr const char room = 0;
+      if (zmq_send(notify_.get(), &room, sizeof(room), ZMQ_DONTWAIT) < 0 && zmq_errno() != EAGAIN)
+        MOT_ZMQ_THROW("Failed to wake intake thread");
+    }
+    return true;
+  }
+  if (failed_.load(std::memory_order_acquire))
+    std::rethrow_exception(error_);
+  return false;
+}
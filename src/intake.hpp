@@ -0,0 +1,122 @@
+// Copyright (c) 2020, Lee Clagett
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOTRIX_INTAKE_HPP
+#define MOTRIX_INTAKE_HPP
+
+#include <atomic>
+#include <exception>
+#include <thread>
+
+#include "expect.hpp"
+#include "pub.hpp"
+#include "spsc_ring.hpp"
+#include "zmq.hpp"
+
+/*! \brief Receives and decodes daemon pub messages on a dedicated thread.
+
+    The worker thread owns the ZMQ/Sub socket. Decoded messages are handed
+    to the render thread through a `spsc_ring`, so a slow parse never delays
+    a frame, and a slow terminal never delays reading the socket. The render
+    thread is woken through an inproc ZMQ/Pair socket, which can be given to
+    `reactor::wait`. The same pair carries subscription changes to the
+    worker, and wakes it when `try_pop` makes room in a full ring.
+
+    Malformed messages are counted (`pub.malformed`) and dropped, so a
+    misbehaving publisher cannot stop intake.
+
+    All sockets are closed by the destructor, on the thread that constructed
+    `this`. */
+class intake
+{
+  spsc_ring<pub::event> events_;
+  zmq::socket sub_;
+  zmq::socket notify_; //!< Used by render thread
+  zmq::socket worker_; //!< Used by intake thread
+  std::exception_ptr error_;
+  std::atomic<bool> failed_;
+  std::atomic<bool> waiting_; //!< Intake thread is (about to be) blocked on a full ring
+  std::thread thread_;
+
+  //! Entry point of `thread_`.
+  void run() noexcept;
+
+  //! Read and decode messages until the ring is full or nothing is queued.
+  expect<void> drain();
+
+public:
+  //! Number of decoded messages that can be queued for the render thread.
+  static constexpr const std::size_t capacity = 256;
+
+  //! Topics given to `subscribe`.
+  enum topics : unsigned
+  {
+    kMinimalChain = 1,
+    kFullChain = 2,
+    kMinimalTxpool = 4
+  };
+
+  /*! Connect to `pub_address` and start the intake thread. Nothing is
+      received until `subscribe` is called.
+
+      \throw std::system_error on failures. */
+  explicit intake(void* ctx, const char* pub_address);
+
+  intake(const intake&) = delete;
+
+  //! Stops and joins the intake thread.
+  ~intake() noexcept;
+
+  intake& operator=(const intake&) = delete;
+
+  //! \return Socket that is readable when events might be queued.
+  void* socket() const noexcept { return notify_.get(); }
+
+  //! Subscribe to exactly `topics` (bitmask). Applied by the intake thread.
+  expect<void> subscribe(unsigned topics);
+
+  /*! Discards wake-ups on `socket()`, so it is readable again only after
+      another message is decoded.
+
+      \return True if `try_pop` will return true or throw. */
+  bool ready() noexcept;
+
+  //! Blocks until `ready()`. \return `ETERM` on shutdown.
+  expect<void> wait();
+
+  /*! Swap the oldest decoded message into `out`, so its buffers are re-used
+      by the intake thread.
+
+      \throw Exception from the intake thread, once all earlier messages
+          are popped.
+      \throw std::system_error if the intake thread cannot be woken.
+      \return False if nothing is queued. */
+  bool try_pop(pub::event& out);
+};
+
+#endif // MOTRIX_INTAKE_HPP
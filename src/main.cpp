@@ -26,13 +26,35 @@
 // STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
 // THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
 #include "engine.hpp"
+#include "stats.hpp"
+
+namespace
+{
+  //! \return Milliseconds in environment variable `name`, or `fallback` if unset.
+  std::chrono::milliseconds get_timeout(const char* name, const std::chrono::milliseconds fallback)
+  {
+    const char* const value = std::getenv(name);
+    if (!value)
+      return fallback;
+
+    char* end = nullptr;
+    const unsigned long ms = std::strtoul(value, &end, 10);
+    if (end == value || *end != 0)
+      throw std::runtime_error{name + std::string{" must be a number of milliseconds"}};
+    return std::chrono::milliseconds{ms};
+  }
+}
 
 int main(int argc, char** argv)
 {
+  int code = 0;
   try
   {
     const char* rpc_address = "tcp://127.0.0.1:18082";
@@ -47,18 +69,25 @@ int main(int argc, char** argv)
     if (4 <= argc)
       color_scheme = argv[3];
 
-    engine::run(argv[1], rpc_address, color_scheme);
+    const engine::timeouts rpc_timeouts{
+      get_timeout("MOTRIX_GET_INFO_TIMEOUT", std::chrono::seconds{5}),
+      get_timeout("MOTRIX_TXPOOL_TIMEOUT", std::chrono::seconds{30})
+    };
+
+    engine::run(argv[1], rpc_address, color_scheme, rpc_timeouts);
   }
   catch (const std::exception& e)
   {
     std::cerr << "Runtime exception: " << e.what() << std::endl;
-    return -1;
+    code = -1;
   }
   catch (...)
   {
     std::cerr << "Unknown runtime exception" << std::endl;
-    return -1;
+    code = -1;
   }
-  
-  return 0;
+
+  if (std::getenv("MOTRIX_STATS"))
+    stats::print(std::cerr);
+  return code;
 }
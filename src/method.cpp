@@ -70,4 +70,13 @@ namespace method
   {
     wire::object(source, WIRE_FIELD(transactions));
   }
+
+  void write_bytes(wire::json_writer& dest, const get_transaction_pool_hashes::request&)
+  {
+    wire::object(dest);
+  }
+  void read_bytes(wire::json_reader& source, get_transaction_pool_hashes::response& self)
+  {
+    wire::object(source, WIRE_FIELD(tx_hashes));
+  }
 }
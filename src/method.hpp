@@ -32,6 +32,8 @@
 #include <cstdint>
 #include <vector>
 
+#include "arena.hpp"
+#include "hash_set.hpp"
 #include "monero_data.hpp"
 #include "wire/json/fwd.hpp"
 
@@ -79,11 +81,26 @@ namespace method
     struct response
     {
       response() = delete;
-      std::vector<entry> transactions;
+      //! From the reply arena when decoded by `rpc::async_client`; thousands of entries when busy.
+      std::vector<entry, arena_allocator<entry>> transactions;
     };
   };
   void write_bytes(wire::json_writer&, const get_transaction_pool::request&);
   void read_bytes(wire::json_reader&, get_transaction_pool::response&);
+
+  //! Only the txpool hashes, instead of every tx in full. Not provided by every daemon.
+  struct get_transaction_pool_hashes
+  {
+    static constexpr const char* name() noexcept { return "get_transaction_pool_hashes"; }
+    struct request {};
+    struct response
+    {
+      response() = delete;
+      hash_set tx_hashes; //!< Decoded directly into the set
+    };
+  };
+  void write_bytes(wire::json_writer&, const get_transaction_pool_hashes::request&);
+  void read_bytes(wire::json_reader&, get_transaction_pool_hashes::response&);
 }
 
 #endif // MOTRIX_METHOD_HPP
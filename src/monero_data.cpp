@@ -37,7 +37,7 @@ namespace
   template<typename F, typename T>
   void minimal_tx_map(F& format, T& self)
   {
-    wire::object(format, WIRE_FIELD(id));
+    wire::ordered_object(format, WIRE_FIELD(id));
   }
 }
 
@@ -45,11 +45,6 @@ namespace monero
 {
   WIRE_DEFINE_OBJECT(minimal_tx, minimal_tx_map);
 
-  void read_bytes(wire::json_reader& source, block& self)
-  {
-    wire::object(source, WIRE_FIELD(tx_hashes), WIRE_FIELD(prev_id));
-  }
-
   int compare(const hash& left, const hash& right) noexcept
   {
     return std::memcmp(left.data, right.data, sizeof(left.data));
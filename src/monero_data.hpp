@@ -57,13 +57,6 @@ namespace monero
     return compare(left, right) != 0;
   }
 
-  struct block
-  {
-    std::vector<monero::hash> tx_hashes;
-    monero::hash prev_id;
-  };
-  void read_bytes(wire::json_reader&, block&);
-
   struct minimal_tx
   {
     monero::hash id;
@@ -29,6 +29,7 @@
 #include "pub.hpp"
 
 #include <cstring>
+#include <functional>
 #include <utility>
 
 #include "wire/field.hpp"
@@ -36,20 +37,52 @@
 
 namespace pub
 {
-  message::message(byte_slice&& raw) noexcept
+  message::message(byte_rope&& raw) noexcept
     : topic(),
       contents(std::move(raw))
   {
-    void const* const split = std::memchr(contents.data(), ':', contents.size());
+    if (contents.empty())
+      return;
+
+    // topic is always in the first segment
+    const byte_slice& first = contents.segment(0);
+    void const* const split = std::memchr(first.data(), ':', first.size());
     if (split)
     {
-      topic = contents.take_slice(static_cast<const std::uint8_t*>(split) - contents.data());
-      contents.remove_prefix(1);
+      topic = first.get_slice(0, static_cast<const std::uint8_t*>(split) - first.data());
+      contents.remove_prefix(topic.size() + 1);
     }
   }
 
   void read_bytes(wire::json_reader& source, minimal_chain& self)
   {
-    wire::object(source, WIRE_FIELD(first_height), WIRE_FIELD(ids), WIRE_FIELD(first_prev_id));
+    // order matches daemon output
+    wire::ordered_object(source, WIRE_FIELD(first_height), WIRE_FIELD(first_prev_id), WIRE_FIELD(ids));
+  }
+
+  void read_bytes(wire::json_reader& source, full_chain& self)
+  {
+    self.tx_hashes.clear();
+    self.blocks = 0;
+    self.last_tx_count = 0;
+
+    // tx hashes of each block are appended as they are parsed
+    const auto add_tx = [&self] (wire::json_reader& source)
+    {
+      self.tx_hashes.emplace_back();
+      read_bytes(source, self.tx_hashes.back());
+    };
+    const auto add_block = [&self, &add_tx] (wire::json_reader& source)
+    {
+      const std::size_t start = self.tx_hashes.size();
+      wire::object(
+        source,
+        WIRE_FIELD_NAMED(tx_hashes, wire::visit_each(add_tx)),
+        WIRE_FIELD_NAMED(prev_id, std::ref(self.last_prev_id))
+      );
+      self.last_tx_count = self.tx_hashes.size() - start;
+      ++self.blocks;
+    };
+    read_json::visit_array(source, add_block);
   }
 }
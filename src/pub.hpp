@@ -32,6 +32,7 @@
 #include <cstdint>
 #include <vector>
 
+#include "byte_rope.hpp"
 #include "byte_slice.hpp"
 #include "monero_data.hpp"
 #include "wire/json/fwd.hpp"
@@ -43,10 +44,10 @@ namespace pub
   struct message
   {
     //! Construct from raw ZMQ/Sub socket message
-    explicit message(byte_slice&& raw) noexcept;
+    explicit message(byte_rope&& raw) noexcept;
 
     byte_slice topic;
-    byte_slice contents;
+    byte_rope contents;
   };
 
   struct minimal_chain
@@ -57,8 +58,28 @@ namespace pub
   };
   void read_bytes(wire::json_reader&, minimal_chain&);
 
-  using full_chain = std::vector<monero::block>;
+  /*! Blocks are streamed while parsing, so only what the engine uses is
+      kept. `tx_hashes` re-uses its capacity across messages. */
+  struct full_chain
+  {
+    std::vector<monero::hash> tx_hashes; //!< From every block, in order
+    std::size_t blocks;
+    std::size_t last_tx_count;           //!< Hashes in `tx_hashes` from the last block
+    monero::hash last_prev_id;
+  };
+  void read_bytes(wire::json_reader&, full_chain&);
   using minimal_txpool = std::vector<monero::minimal_tx>;
+
+  //! A decoded pub message, handed from the intake thread to the render thread.
+  struct event
+  {
+    enum class kind : std::uint8_t { none = 0, minimal_chain, full_chain, minimal_txpool };
+
+    kind type;
+    minimal_chain chain;   //!< Valid if `type == kind::minimal_chain`
+    full_chain blocks;     //!< Valid if `type == kind::full_chain`
+    minimal_txpool txpool; //!< Valid if `type == kind::minimal_txpool`
+  };
 }
 
 #endif // MOTRIX_PUB_HPP
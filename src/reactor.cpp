@@ -0,0 +1,352 @@
+// Copyright (c) 2020, Lee Clagett
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "reactor.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <initializer_list>
+#include <limits>
+#include <stdexcept>
+#include <unistd.h>
+#include <zmq.h>
+
+#if defined(HAVE_SYS_EPOLL_H) && defined(HAVE_SYS_SIGNALFD_H) && defined(HAVE_SYS_TIMERFD_H)
+  #define MOTRIX_USE_EPOLL 1
+  #include <pthread.h>
+  #include <sys/epoll.h>
+  #include <sys/signalfd.h>
+  #include <sys/timerfd.h>
+#endif
+
+#include "error.hpp"
+#include "zmq.hpp"
+
+//! \return Error from `errno` if `result` is less than 0.
+#define POSIX_CHECK(...)                                 \
+  do                                                     \
+  {                                                      \
+    if ((__VA_ARGS__) < 0)                               \
+      return {std::make_error_code(std::errc(errno))};   \
+  } while (0)
+
+//! Executes the POSIX function. \throw std::system_error on failures.
+#define POSIX_UNWRAP(...)                                      \
+  if ((__VA_ARGS__) < 0)                                       \
+    MOT_THROW(make_error_code(std::errc(errno)), #__VA_ARGS__)
+
+reactor* reactor::instance_{nullptr};
+std::atomic<bool> reactor::exit_{false};
+
+namespace
+{
+  //! Signals handled by `reactor`
+  constexpr const int exit_signals[] = {SIGINT, SIGTERM};
+
+  //! \return True if `socket` has a message ready to read.
+  bool is_readable(void* socket) noexcept
+  {
+    int events = 0;
+    std::size_t length = sizeof(events);
+    // any error is treated as readable, so that the next read reports it
+    return zmq_getsockopt(socket, ZMQ_EVENTS, &events, &length) != 0 || (events & ZMQ_POLLIN);
+  }
+
+#ifndef MOTRIX_USE_EPOLL
+  //! Write end of self-pipe, for use in signal handlers
+  int signal_write = -1;
+
+  extern "C" void on_signal(const int signal)
+  {
+    // pipe is non-blocking; if full, a wakeup is already pending
+    const char value = (signal == SIGWINCH) ? 'w' : 'x';
+    const int last = errno;
+    const ssize_t unused = ::write(signal_write, &value, 1);
+    (void)unused;
+    errno = last;
+  }
+#endif
+}
+
+void reactor::close_all() noexcept
+{
+  for (int* fd : {&wait_fd_, &signal_fd_, &timer_fd_})
+  {
+    if (0 <= *fd)
+      ::close(*fd);
+    *fd = -1;
+  }
+#ifndef MOTRIX_USE_EPOLL
+  if (0 <= signal_write)
+    ::close(signal_write);
+  signal_write = -1;
+#endif
+}
+
+bool reactor::read_signals() noexcept
+{
+  const bool was_resized = resized_;
+#ifdef MOTRIX_USE_EPOLL
+  signalfd_siginfo info[8];
+  for (;;)
+  {
+    const ssize_t bytes = ::read(signal_fd_, info, sizeof(info));
+    if (bytes <= 0)
+      break;
+    for (std::size_t i = 0; i < std::size_t(bytes) / sizeof(info[0]); ++i)
+    {
+      if (info[i].ssi_signo == SIGWINCH)
+        resized_ = true;
+      else
+        exit_ = true;
+    }
+  }
+#else
+  char values[16];
+  for (;;)
+  {
+    const ssize_t bytes = ::read(signal_fd_, values, sizeof(values));
+    if (bytes <= 0)
+      break;
+    if (std::find(values, values + bytes, 'w') != values + bytes)
+      resized_ = true;
+    if (std::find(values, values + bytes, 'x') != values + bytes)
+      exit_ = true;
+  }
+#endif
+  return !was_resized && resized_;
+}
+
+expect<void> reactor::arm(const clock::time_point deadline) noexcept
+{
+#ifdef MOTRIX_USE_EPOLL
+  if (deadline == armed_)
+    return success();
+
+  /* `steady_clock` is `CLOCK_MONOTONIC` on Linux (libstdc++ and libc++), so
+     the deadline is used as an absolute expiration - no drift from
+     re-computing a relative timeout every frame. */
+  itimerspec value{};
+  if (deadline != clock::time_point::max())
+  {
+    using namespace std::chrono;
+    const auto since = std::max(deadline.time_since_epoch(), clock::duration{1});
+    const auto secs = duration_cast<seconds>(since);
+    value.it_value.tv_sec = secs.count();
+    value.it_value.tv_nsec = duration_cast<nanoseconds>(since - secs).count();
+  }
+  POSIX_CHECK(timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &value, nullptr));
+  armed_ = deadline;
+#endif
+  return success();
+}
+
+void reactor::watch(void* const socket)
+{
+#ifdef MOTRIX_USE_EPOLL
+  for (const auto& entry : sockets_)
+  {
+    if (entry.first == socket)
+      return;
+  }
+
+  int fd = -1;
+  std::size_t length = sizeof(fd);
+  if (zmq_getsockopt(socket, ZMQ_FD, &fd, &length) != 0)
+    MOT_ZMQ_THROW("Failed to get ZMQ_FD");
+
+  epoll_event event{};
+  event.events = EPOLLIN | EPOLLET;
+  event.data.fd = fd;
+  POSIX_UNWRAP(epoll_ctl(wait_fd_, EPOLL_CTL_ADD, fd, &event));
+  sockets_.emplace_back(socket, fd);
+#endif
+}
+
+reactor::reactor()
+  : wait_fd_(-1),
+    signal_fd_(-1),
+    timer_fd_(-1),
+    armed_(clock::time_point::max()),
+    sockets_(),
+    resized_(false)
+{
+  if (instance_)
+    throw std::logic_error{"Only one reactor instance allowed"};
+
+  try
+  {
+#ifdef MOTRIX_USE_EPOLL
+    sigset_t signals{};
+    sigemptyset(&signals);
+    for (const int signal : exit_signals)
+      sigaddset(&signals, signal);
+    sigaddset(&signals, SIGWINCH);
+
+    // threads created after this inherit the mask; signals only go to `signal_fd_`
+    const int blocked = pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    if (blocked)
+      MOT_THROW(make_error_code(std::errc(blocked)), "pthread_sigmask");
+
+    POSIX_UNWRAP(wait_fd_ = epoll_create1(EPOLL_CLOEXEC));
+    POSIX_UNWRAP(signal_fd_ = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC));
+    POSIX_UNWRAP(timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC));
+
+    for (const int fd : {signal_fd_, timer_fd_})
+    {
+      epoll_event event{};
+      event.events = EPOLLIN;
+      event.data.fd = fd;
+      POSIX_UNWRAP(epoll_ctl(wait_fd_, EPOLL_CTL_ADD, fd, &event));
+    }
+#else
+    int signal_pipe[2] = {-1, -1};
+    POSIX_UNWRAP(pipe(signal_pipe));
+    signal_fd_ = signal_pipe[0];
+    signal_write = signal_pipe[1];
+    for (const int fd : signal_pipe)
+      POSIX_UNWRAP(fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK));
+
+    struct sigaction action{};
+    action.sa_handler = on_signal;
+    sigemptyset(&action.sa_mask);
+    for (const int signal : exit_signals)
+      POSIX_UNWRAP(sigaction(signal, &action, nullptr));
+    POSIX_UNWRAP(sigaction(SIGWINCH, &action, nullptr));
+#endif
+  }
+  catch (...)
+  {
+    close_all();
+    throw;
+  }
+
+  instance_ = this;
+}
+
+reactor::~reactor() noexcept
+{
+#ifndef MOTRIX_USE_EPOLL
+  for (const int signal : exit_signals)
+    std::signal(signal, SIG_DFL);
+  std::signal(SIGWINCH, SIG_DFL);
+#endif
+  close_all();
+  instance_ = nullptr;
+}
+
+void reactor::forget(void* const socket) noexcept
+{
+  reactor* const self = instance();
+  if (!self)
+    return;
+
+  const auto match = std::find_if(
+    self->sockets_.begin(), self->sockets_.end(),
+    [socket] (const std::pair<void*, int>& entry) { return entry.first == socket; }
+  );
+  if (match != self->sockets_.end())
+  {
+#ifdef MOTRIX_USE_EPOLL
+    epoll_event unused{}; // non-null required by older kernels
+    epoll_ctl(self->wait_fd_, EPOLL_CTL_DEL, match->second, &unused);
+#endif
+    self->sockets_.erase(match);
+  }
+}
+
+expect<reactor::events> reactor::wait(const span<void* const> sockets, const clock::time_point deadline)
+{
+  if (max_sockets < sockets.size())
+    return {common_error::kInvalidArgument};
+
+  for (void* const socket : sockets)
+  {
+    if (socket)
+      watch(socket);
+  }
+
+  for (;;)
+  {
+    events out{0, false, false, false};
+    for (std::size_t i = 0; i < sockets.size(); ++i)
+    {
+      if (sockets[i] && is_readable(sockets[i]))
+        out.readable |= (1u << i);
+    }
+
+    const bool new_resize = read_signals();
+    out.exit = exit_requested();
+    out.resize = resized_;
+    out.timeout = (deadline != clock::time_point::max() && deadline <= clock::now());
+    if (out.readable || out.exit || new_resize || out.timeout)
+      return out;
+
+#ifdef MOTRIX_USE_EPOLL
+    MOT_CHECK(arm(deadline));
+
+    epoll_event ready[8];
+    const int count = epoll_wait(wait_fd_, ready, 8, -1);
+    if (count < 0 && errno != EINTR)
+      return {std::make_error_code(std::errc(errno))};
+
+    // timerfd must be drained, or it stays readable
+    for (int i = 0; i < count; ++i)
+    {
+      if (ready[i].data.fd == timer_fd_)
+      {
+        std::uint64_t expirations = 0;
+        if (::read(timer_fd_, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN)
+          return {std::make_error_code(std::errc(errno))};
+      }
+    }
+#else
+    using namespace std::chrono;
+    long timeout = -1;
+    if (deadline != clock::time_point::max())
+    {
+      // round up, otherwise poll can return (early) without an event
+      timeout = std::min<long>(
+        std::numeric_limits<int>::max(),
+        duration_cast<milliseconds>(deadline - clock::now() + milliseconds{1} - nanoseconds{1}).count()
+      );
+    }
+
+    int count = 1;
+    zmq_pollitem_t items[max_sockets + 1] = {{nullptr, signal_fd_, ZMQ_POLLIN, 0}};
+    for (void* const socket : sockets)
+    {
+      if (socket)
+        items[count++] = {socket, 0, ZMQ_POLLIN, 0};
+    }
+    MOT_CHECK(zmq::retry_op(zmq_poll, items, count, std::max(-1L, timeout)));
+#endif
+  }
+}
@@ -0,0 +1,118 @@
+// Copyright (c) 2020, Lee Clagett
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOTRIX_REACTOR_HPP
+#define MOTRIX_REACTOR_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "expect.hpp"
+#include "span.hpp"
+
+/*! \brief Single wait point for ZMQ sockets, signals and a deadline.
+
+    On Linux, `epoll` waits on the `ZMQ_FD` of each socket (edge-triggered,
+    so `ZMQ_EVENTS` is always checked before sleeping), a `signalfd` for
+    SIGINT/SIGTERM/SIGWINCH, and a `timerfd` armed with an absolute deadline.
+    Elsewhere `zmq_poll` is used, with a self-pipe written by signal handlers.
+
+    Only one instance can exist at a time, and it must be constructed before
+    any other thread (including ZMQ context threads) is started, so that every
+    thread inherits the blocked signal mask. */
+class reactor
+{
+  static reactor* instance_;
+  static std::atomic<bool> exit_;
+
+  int wait_fd_;   //!< epoll instance, or -1
+  int signal_fd_; //!< signalfd, or read end of self-pipe
+  int timer_fd_;  //!< timerfd, or -1
+  std::chrono::steady_clock::time_point armed_; //!< Current `timer_fd_` expiration
+  std::vector<std::pair<void*, int>> sockets_;  //!< ZMQ sockets in `wait_fd_`
+  bool resized_;
+
+  //! Read every pending signal. \return True if `resized_` changed to true.
+  bool read_signals() noexcept;
+
+  //! Set timer to `deadline` if not already set. \return `success()` or system error.
+  expect<void> arm(std::chrono::steady_clock::time_point deadline) noexcept;
+
+  //! Add `socket` to `wait_fd_` if not already present. \throw std::system_error
+  void watch(void* socket);
+
+  void close_all() noexcept;
+
+public:
+  using clock = std::chrono::steady_clock;
+
+  //! Maximum number of sockets given to `wait`.
+  static constexpr const std::size_t max_sockets = 8;
+
+  struct events
+  {
+    unsigned readable; //!< Bit `i` is set if `sockets[i]` is readable
+    bool timeout;      //!< Deadline was reached
+    bool exit;         //!< SIGINT or SIGTERM received (every call after)
+    bool resize;       //!< SIGWINCH received, and not yet acknowledged
+  };
+
+  //! \throw std::system_error on failures, std::logic_error if another instance exists.
+  reactor();
+
+  reactor(const reactor&) = delete;
+  ~reactor() noexcept;
+  reactor& operator=(const reactor&) = delete;
+
+  //! \return Current reactor or `nullptr`.
+  static reactor* instance() noexcept { return instance_; }
+
+  //! \return True if SIGINT or SIGTERM was received. Safe from any thread.
+  static bool exit_requested() noexcept { return exit_; }
+
+  //! Drop `socket` from wait lists. Must be called before `zmq_close`.
+  static void forget(void* socket) noexcept;
+
+  //! Clears `events::resize` until the next SIGWINCH.
+  void acknowledge_resize() noexcept { resized_ = false; }
+
+  /*! Wait until a socket in `sockets` is readable, `deadline` is reached,
+      or a signal is received. Never blocks if any of those already
+      occurred, except for an unacknowledged SIGWINCH (which is reported, but
+      does not end the wait again). `nullptr` entries are skipped.
+      `clock::time_point::max()` waits without a deadline.
+
+      \throw std::system_error if a socket cannot be added to the wait list.
+      \return Events that occurred, or system/ZMQ error. */
+  expect<events> wait(span<void* const> sockets, clock::time_point deadline);
+};
+
+#endif // MOTRIX_REACTOR_HPP
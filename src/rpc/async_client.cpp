@@ -0,0 +1,229 @@
+// Copyright (c) 2020, Lee Clagett
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rpc/async_client.hpp"
+
+#include "arena.hpp"
+#include "rpc/client.hpp"
+#include "stats.hpp"
+#include "wire/error.hpp"
+#include "wire/field.hpp"
+#include "wire/json/read.hpp"
+
+namespace rpc
+{
+  namespace
+  {
+    stats::counter requests{"rpc.async.requests"};
+    stats::counter unmatched{"rpc.async.unmatched"};
+    stats::counter timeouts{"rpc.async.timeouts"};
+    stats::gauge in_flight{"rpc.async.in_flight"};
+    stats::latency latency{"rpc.async.latency"};
+
+    //! Only the `id` of a JSON-RPC response, other fields are skipped.
+    struct response_id
+    {
+      unsigned id;
+    };
+
+    void read_bytes(wire::json_reader& source, response_id& self)
+    {
+      wire::object(source, WIRE_FIELD(id));
+    }
+
+    //! Keys of a JSON-RPC reply object, indexed by `reply_key`.
+    enum reply_key : std::size_t { kId = 0, kResult, kError };
+    const wire::json_reader::key_map reply_keys[] = {
+      {"id", 2, wire::key_hash("id")},
+      {"result", 6, wire::key_hash("result")},
+      {"error", 5, wire::key_hash("error")}
+    };
+
+    span<const std::uint8_t> reply_slots()
+    {
+      return read_json::key_table<wire::key_hash("id"), wire::key_hash("result"), wire::key_hash("error")>::get();
+    }
+
+    /*! Start the reply object in `source`, and read `id` if it is the
+        first known key (the daemon writes it before `result`).
+        \return False if `id` was not read. */
+    bool read_reply_id(wire::json_reader& source, unsigned& id)
+    {
+      source.start_object();
+
+      std::size_t next = 0;
+      if (!source.key(reply_keys, reply_slots(), 0, next) || next != kId)
+        return false;
+      read_bytes(source, id);
+      return !source.failed();
+    }
+  }
+
+  std::error_code async_client::read_reply(wire::json_reader& source, std::size_t count, const std::function<void(wire::json_reader&)>& read_result)
+  {
+    bool has_result = false;
+    std::error_code error{};
+
+    std::size_t next = 0;
+    const span<const std::uint8_t> slots = reply_slots();
+    for ( ; source.key(reply_keys, slots, count, next); ++count)
+    {
+      switch (next)
+      {
+      default:
+      case kId:
+      {
+        unsigned id = 0;
+        read_bytes(source, id); // matched by `process`
+        break;
+      }
+      case kResult:
+        read_result(source);
+        has_result = true;
+        break;
+      case kError:
+        error = read_json_error(source);
+        break;
+      }
+    }
+    source.end_object();
+    source.check_complete();
+
+    if (error)
+      return error;
+    if (source.failed())
+      return source.error();
+    if (!has_result)
+      return wire::error::schema::missing_key;
+    return {};
+  }
+
+  expect<void> async_client::send(const unsigned id, byte_slice&& request, std::unique_ptr<handler> complete, const std::chrono::steady_clock::time_point deadline)
+  {
+    if (!socket_)
+      socket_ = rpc::connect(ctx_, ZMQ_DEALER, address_);
+
+    // empty delimiter frame is expected by the daemon ZMQ_REP socket
+    expect<void> sent = zmq::retry_op(zmq_send, socket_.get(), nullptr, 0, ZMQ_SNDMORE);
+    if (sent)
+      sent = zmq::send(std::move(request), socket_.get());
+    if (!sent)
+    {
+      cancel();
+      socket_.reset();
+      return sent;
+    }
+
+    pending_.emplace(id, call{std::move(complete), std::chrono::steady_clock::now(), deadline});
+    requests.increment();
+    in_flight.add(1);
+    return success();
+  }
+
+  void async_client::cancel() noexcept
+  {
+    in_flight.subtract(pending_.size());
+    pending_.clear();
+  }
+
+  std::size_t async_client::expire(const std::chrono::steady_clock::time_point now) noexcept
+  {
+    std::size_t expired = 0;
+    for (auto current = pending_.begin(); current != pending_.end(); )
+    {
+      if (current->second.deadline < now)
+      {
+        current = pending_.erase(current);
+        ++expired;
+      }
+      else
+        ++current;
+    }
+
+    timeouts.add(expired);
+    in_flight.subtract(expired);
+    return expired;
+  }
+
+  expect<std::size_t> async_client::process()
+  {
+    std::size_t completed = 0;
+    while (socket_)
+    {
+      expect<byte_rope> reply = zmq::receive_segments(socket_.get(), ZMQ_DONTWAIT);
+      if (!reply)
+      {
+        if (reply == zmq::make_error_code(EAGAIN))
+          break;
+        cancel();
+        socket_.reset();
+        return reply.error();
+      }
+
+      // `arena_allocator` containers in every response are freed together
+      const arena::scope message{};
+      const wire::json_context context{};
+      wire::json_reader& source = *context;
+
+      // empty delimiter frame was dropped by `byte_rope`; `"id": null` or garbled replies cannot be matched
+      unsigned id = 0;
+      std::size_t count = 1; // keys already read by `read_reply_id`
+      source.reset(reply->clone());
+      bool has_id = read_reply_id(source, id);
+      if (!has_id)
+      {
+        // `id` is not first; find it, then read the reply again from the start
+        response_id response{};
+        has_id = bool(wire::json::try_from_bytes(reply->clone(), response, source));
+        if (has_id)
+        {
+          id = response.id;
+          count = 0;
+          source.reset(std::move(*reply));
+          source.start_object();
+        }
+      }
+
+      const auto match = has_id ? pending_.find(id) : pending_.end();
+      if (match == pending_.end())
+      {
+        unmatched.increment(); // cancelled call or unreadable reply
+        continue;
+      }
+
+      const std::unique_ptr<handler> complete{std::move(match->second.complete)};
+      latency.add(std::chrono::steady_clock::now() - match->second.start);
+      in_flight.subtract(1);
+      pending_.erase(match);
+
+      complete->finish(source, id, count);
+      ++completed;
+    }
+    return completed;
+  }
+}
@@ -0,0 +1,190 @@
+// Copyright (c) 2020, Lee Clagett
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOTRIX_RPC_ASYNC_CLIENT_HPP
+#define MOTRIX_RPC_ASYNC_CLIENT_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include "byte_slice.hpp"
+#include "expect.hpp"
+#include "rpc/json_error.hpp"
+#include "wire/json/fwd.hpp"
+#include "zmq.hpp"
+
+namespace rpc
+{
+  /*! \brief Pipelined JSON-RPC over a ZMQ_DEALER socket.
+
+      Several requests can be in flight; each is given a unique JSON-RPC `id`
+      and replies are matched by that `id`. Handlers are only invoked from
+      `process()`, which should be called from the event loop whenever
+      `socket()` is readable. Any socket error cancels every pending call,
+      and the socket is re-created on the next `try_invoke`.
+
+      A reply is decoded in one pass: `process()` reads the `id`, and the
+      matching handler continues from there with the `result` or `error`. */
+  class async_client
+  {
+    //! Decodes the rest of a reply into the response type of one call.
+    struct handler
+    {
+      virtual ~handler() noexcept {}
+
+      /*! Read the remaining keys of a reply (see `read_reply`), then invoke
+          the callback. Called within an `arena::scope`. */
+      virtual void finish(wire::json_reader& source, unsigned id, std::size_t count) = 0;
+    };
+
+    struct call
+    {
+      std::unique_ptr<handler> complete;
+      std::chrono::steady_clock::time_point start;
+      std::chrono::steady_clock::time_point deadline;
+    };
+
+    void* const ctx_;
+    const char* const address_;
+    zmq::socket socket_;
+    std::map<unsigned, call> pending_;
+    unsigned next_id_;
+
+    //! \throw std::system_error if the socket cannot be created.
+    expect<void> send(unsigned id, byte_slice&& request, std::unique_ptr<handler> complete, std::chrono::steady_clock::time_point deadline);
+
+    /*! Read the keys of a reply object after the first `count`, calling
+        `read_result` at the `result` value. The reply object is ended.
+
+        \return `json_error` if the reply has an `error` object, otherwise a
+            decode error, or `missing_key` if there is no `result`. */
+    static std::error_code read_reply(wire::json_reader& source, std::size_t count, const std::function<void(wire::json_reader&)>& read_result);
+
+  public:
+    //! `ctx` must outlive `this`, and `address` must be in static memory.
+    explicit async_client(void* ctx, const char* address) noexcept
+      : ctx_(ctx), address_(address), socket_(), pending_(), next_id_(0)
+    {}
+
+    async_client(const async_client&) = delete;
+    async_client& operator=(const async_client&) = delete;
+
+    //! \return Socket for use with `zmq_poll`, or `nullptr` if not connected.
+    void* socket() const noexcept { return socket_.get(); }
+
+    //! \return Number of calls waiting for a reply.
+    std::size_t pending() const noexcept { return pending_.size(); }
+
+    //! Drop every pending handler. Late replies are discarded.
+    void cancel() noexcept;
+
+    /*! Drop handlers whose deadline is before `now`. Late replies are
+        discarded.
+
+        \return Number of calls dropped. */
+    std::size_t expire(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now()) noexcept;
+
+    /*! Read every available reply without blocking, and invoke the matching
+        handlers. Exceptions thrown by a handler are propagated. Replies
+        without a readable `id` are dropped (counted as unmatched); their call
+        stays pending until `expire()`. An `id` after the `result` costs a
+        second pass over the reply.
+
+        \return Number of handlers invoked, or ZMQ error. */
+    expect<std::size_t> process();
+
+    /*! Queue a request; `complete` is invoked with the response from a later
+        `process()` call, unless the call is removed by `expire()` after
+        `deadline`. Must not be invoked if `complete` references an object
+        that could be destroyed before `cancel()` is called.
+
+      \tparam RPC must implement the RPC concept defined in `zmq.hpp`, and
+        `RPC::request` must have an `id` field.
+
+      \param complete callable with `expect<RPC::response>&&`. A reply that
+        cannot be decoded as `RPC::response` is given as an error: a
+        `json_error` if the reply has a JSON-RPC `error` object, otherwise
+        the decode error. Containers using `arena_allocator` are released
+        after `complete` returns, and must not be kept.
+      \param args are forwarded to the RPC request, and can be empty.
+      \throw std::system_error if the socket cannot be created.
+      \return `success()` if sent, otherwise ZMQ error. */
+    template<typename RPC, typename F, typename... U>
+    expect<void> try_invoke(const std::chrono::steady_clock::time_point deadline, F&& complete, U&&... args)
+    {
+      using response = typename RPC::response;
+      using callback = typename std::decay<F>::type;
+
+      struct parse final : handler
+      {
+        callback complete;
+
+        explicit parse(F&& complete)
+          : complete(std::forward<F>(complete))
+        {}
+
+        virtual void finish(wire::json_reader& source, const unsigned id, const std::size_t count) override final
+        {
+          // within `arena::scope`, so `arena_allocator` containers in `response` are freed together
+          response value{};
+          value.id = id;
+          const std::error_code error = read_reply(source, count, [&value] (wire::json_reader& result) {
+            read_bytes(result, value.result);
+          });
+          if (error)
+            return complete(expect<response>{error});
+          complete(expect<response>{std::move(value)});
+        }
+      };
+
+      return queue<RPC>(deadline, std::unique_ptr<handler>{new parse{std::forward<F>(complete)}}, std::forward<U>(args)...);
+    }
+
+  private:
+    //! Send `RPC::request` constructed from `args`, with `parse` as handler.
+    template<typename RPC, typename... U>
+    expect<void> queue(const std::chrono::steady_clock::time_point deadline, std::unique_ptr<handler> parse, U&&... args)
+    {
+      using format = typename RPC::wire_type;
+      using request = typename RPC::request;
+
+      const unsigned id = next_id_++;
+      request message{std::forward<U>(args)...};
+      message.id = id;
+      return send(id, format::to_bytes(message), std::move(parse), deadline);
+    }
+  };
+}
+
+#endif // MOTRIX_RPC_ASYNC_CLIENT_HPP
@@ -0,0 +1,133 @@
+// Copyright (c) 2020, Lee Clagett
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rpc/client.hpp"
+
+#include <chrono>
+
+#include "error.hpp"
+#include "stats.hpp"
+
+namespace rpc
+{
+  namespace
+  {
+    //! Interval between ZMTP pings on an idle connection
+    constexpr const int heartbeat_interval_ms = 10000;
+
+    //! Connection dropped (and re-established) if no traffic within this time
+    constexpr const int heartbeat_timeout_ms = 30000;
+
+    stats::counter connects{"rpc.connects"};
+    stats::counter reconnects{"rpc.reconnects"};
+    stats::counter timeouts{"rpc.timeouts"};
+    stats::latency latency{"rpc.latency"};
+
+    void set_option(void* socket, const int option, const int value)
+    {
+      if (zmq_setsockopt(socket, option, &value, sizeof(value)) != 0)
+        MOT_ZMQ_THROW("Failed to set RPC socket option");
+    }
+  }
+
+  zmq::socket connect(void* const ctx, const int type, const char* const address)
+  {
+    zmq::socket out{zmq_socket(ctx, type)};
+    if (!out)
+      MOT_ZMQ_THROW("Failed to create socket");
+
+    // heartbeat options only apply to connections made after they are set
+    set_option(out.get(), ZMQ_LINGER, 0);
+#ifdef ZMQ_HEARTBEAT_IVL
+    set_option(out.get(), ZMQ_HEARTBEAT_IVL, heartbeat_interval_ms);
+    set_option(out.get(), ZMQ_HEARTBEAT_TIMEOUT, heartbeat_timeout_ms);
+    set_option(out.get(), ZMQ_HEARTBEAT_TTL, heartbeat_timeout_ms);
+#endif
+    if (zmq_connect(out.get(), address) != 0)
+      MOT_ZMQ_THROW("Failed to connect socket");
+    return out;
+  }
+
+  void client::connect()
+  {
+    socket_ = rpc::connect(ctx_, ZMQ_REQ, address_);
+    pending_ = false;
+
+    connects.increment();
+    if (connected_)
+      reconnects.increment();
+    connected_ = true;
+  }
+
+  expect<byte_slice> client::call(byte_slice&& request, const std::chrono::steady_clock::time_point deadline)
+  {
+    // previous reply never read; a REQ socket cannot send again
+    if (pending_)
+      reset();
+    if (!socket_)
+      connect();
+
+    const auto start = std::chrono::steady_clock::now();
+    expect<void> sent = zmq::send(request.clone(), socket_.get());
+    if (sent == zmq::make_error_code(EFSM))
+    {
+      reset();
+      connect();
+      sent = zmq::send(std::move(request), socket_.get());
+    }
+    if (!sent)
+    {
+      reset();
+      return sent.error();
+    }
+
+    pending_ = true;
+    const expect<void> ready = deadline == std::chrono::steady_clock::time_point::max() ?
+      zmq::wait_for(socket_.get()) : zmq::wait_for(socket_.get(), deadline);
+    if (!ready)
+    {
+      if (ready == common_error::kTimedOut)
+      {
+        timeouts.increment();
+        reset();
+      }
+      return ready.error();
+    }
+
+    expect<byte_slice> reply = zmq::receive(socket_.get());
+    if (!reply)
+    {
+      reset();
+      return reply.error();
+    }
+
+    pending_ = false;
+    latency.add(std::chrono::steady_clock::now() - start);
+    return reply;
+  }
+}
@@ -0,0 +1,126 @@
+// Copyright (c) 2020, Lee Clagett
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOTRIX_RPC_CLIENT_HPP
+#define MOTRIX_RPC_CLIENT_HPP
+
+#include <chrono>
+#include <utility>
+
+#include "byte_slice.hpp"
+#include "expect.hpp"
+#include "zmq.hpp"
+
+namespace rpc
+{
+  /*! Create a socket of `type` with ZMQ heartbeats enabled, and connect it to
+      `address`.
+
+      \throw std::system_error on any errors.
+      \return Pointer to socket. Never `NULL`. */
+  zmq::socket connect(void* ctx, int type, const char* address);
+
+  /*! \brief Long-lived ZMQ_REQ connection to the daemon.
+
+      The socket is created on first use, and kept open between calls so that
+      TCP and ZMTP handshakes are not paid on every request. ZMQ heartbeats
+      detect a dead peer while idle (ZMQ then reconnects internally). The
+      socket is re-created on the next call after any send or receive
+      failure, or if a previous reply was never read (REQ/REP lockstep). */
+  class client
+  {
+    void* const ctx_;
+    const char* const address_;
+    zmq::socket socket_;
+    bool pending_;   //!< Request sent, but reply not yet read
+    bool connected_; //!< Socket was created at least once
+
+    //! \throw std::system_error if the socket cannot be created.
+    void connect();
+
+  public:
+    //! `ctx` must outlive `this`, and `address` must be in static memory.
+    explicit client(void* ctx, const char* address) noexcept
+      : ctx_(ctx), address_(address), socket_(), pending_(false), connected_(false)
+    {}
+
+    client(const client&) = delete;
+    client& operator=(const client&) = delete;
+
+    const char* address() const noexcept { return address_; }
+
+    //! Close connection; a new one is made on the next call.
+    void reset() noexcept
+    {
+      socket_.reset();
+      pending_ = false;
+    }
+
+    /*! Send `request` and wait for the reply until `deadline`. Returns
+        `ETERM` if the wait was interrupted by SIGINT/SIGTERM or context
+        termination. The connection is reset after a timeout, so a late reply
+        is never mistaken for the response to the next request.
+
+        \throw std::system_error if the socket cannot be created.
+        \return Reply payload, `common_error::kTimedOut`, or ZMQ error. */
+    expect<byte_slice> call(byte_slice&& request, std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max());
+
+    /*!
+      \tparam RPC must implement the RPC concept defined in `zmq.hpp`.
+
+      \param args are forwarded to the RPC request, and can be empty. */
+    template<typename RPC, typename... U>
+    expect<typename RPC::response> invoke(U&&... args)
+    {
+      using format = typename RPC::wire_type;
+      using request = typename RPC::request;
+      using response = typename RPC::response;
+
+      expect<byte_slice> message = call(format::to_bytes(request{std::forward<U>(args)...}));
+      if (!message)
+        return message.error();
+      return format::template from_bytes<response>(std::move(*message));
+    }
+
+    //! Same as `invoke` above, except the call fails at `deadline`.
+    template<typename RPC, typename... U>
+    expect<typename RPC::response> invoke(const std::chrono::steady_clock::time_point deadline, U&&... args)
+    {
+      using format = typename RPC::wire_type;
+      using request = typename RPC::request;
+      using response = typename RPC::response;
+
+      expect<byte_slice> message = call(format::to_bytes(request{std::forward<U>(args)...}), deadline);
+      if (!message)
+        return message.error();
+      return format::template from_bytes<response>(std::move(*message));
+    }
+  };
+}
+
+#endif // MOTRIX_RPC_CLIENT_HPP
@@ -0,0 +1,93 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "rpc/json_error.hpp"
+
+#include <string>
+
+#include "wire/field.hpp"
+#include "wire/json.hpp"
+
+namespace rpc
+{
+  namespace
+  {
+    struct error_object
+    {
+      int code;
+    };
+
+    void read_bytes(wire::json_reader& source, error_object& self)
+    {
+      wire::object(source, WIRE_FIELD(code));
+    }
+  }
+
+  const std::error_category& json_error_category() noexcept
+  {
+    struct category final : std::error_category
+    {
+      virtual const char* name() const noexcept override final
+      {
+        return "rpc::json_error_category()";
+      }
+
+      virtual std::string message(int value) const override final
+      {
+        switch (json_error(value))
+        {
+        default:
+          break;
+
+        case json_error::none:
+          return "No JSON-RPC error";
+        case json_error::parse_error:
+          return "JSON-RPC parse error";
+        case json_error::invalid_request:
+          return "JSON-RPC invalid request";
+        case json_error::method_not_found:
+          return "JSON-RPC method not found";
+        case json_error::invalid_params:
+          return "JSON-RPC invalid method parameters";
+        case json_error::internal_error:
+          return "JSON-RPC internal error";
+        }
+        return "JSON-RPC error " + std::to_string(value);
+      }
+    };
+    static const category instance{};
+    return instance;
+  }
+
+  std::error_code read_json_error(wire::json_reader& source)
+  {
+    error_object error{};
+    read_bytes(source, error);
+    return json_error(error.code);
+  }
+}
@@ -0,0 +1,74 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOTRIX_RPC_JSON_ERROR_HPP
+#define MOTRIX_RPC_JSON_ERROR_HPP
+
+#include <system_error>
+#include <type_traits>
+
+#include "wire/json/fwd.hpp"
+
+namespace rpc
+{
+  //! Codes from the `error` object of a JSON-RPC 2.0 reply.
+  enum class json_error : int
+  {
+    none = 0,                  //!< Must be zero for `expect<..>`
+    parse_error = -32700,      //!< Daemon could not parse request
+    invalid_request = -32600,  //!< Request is not a valid JSON-RPC object
+    method_not_found = -32601, //!< Daemon does not have the method
+    invalid_params = -32602,   //!< Method parameters are invalid
+    internal_error = -32603    //!< Daemon failed to process request
+  };
+
+  //! \return Category for `json_error`; other (daemon specific) codes are kept as-is.
+  const std::error_category& json_error_category() noexcept;
+
+  //! \return Error code with `value` and `json_error_category()`.
+  inline std::error_code make_error_code(const json_error value) noexcept
+  {
+    return std::error_code{int(value), json_error_category()};
+  }
+
+  /*! Read the `error` object of a reply, at the current position of
+      `source`. Failures are recorded in `source`.
+
+      \return `json_error` from `error.code`, which is false if zero. */
+  std::error_code read_json_error(wire::json_reader& source);
+}
+
+namespace std
+{
+  template<>
+  struct is_error_code_enum<rpc::json_error>
+    : true_type
+  {};
+}
+
+#endif // MOTRIX_RPC_JSON_ERROR_HPP
@@ -0,0 +1,116 @@
+// Copyright (c) 2020, Lee Clagett
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOTRIX_SPSC_RING_HPP
+#define MOTRIX_SPSC_RING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+/*! \brief Bounded lock-free queue for one producer and one consumer thread.
+
+    Every slot is constructed once, and re-used. The producer fills a slot in
+    place (`back()` then `push()`), and the consumer swaps the slot contents
+    out (`try_pop`), so buffers owned by `T` (i.e. `std::vector` capacity) are
+    recycled between both threads instead of re-allocated. */
+template<typename T>
+class spsc_ring
+{
+  std::unique_ptr<T[]> slots_;
+  const std::size_t mask_;
+  alignas(64) std::atomic<std::size_t> head_; //!< Next slot to read, written by consumer
+  alignas(64) std::atomic<std::size_t> tail_; //!< Next slot to write, written by producer
+
+  static std::size_t check_capacity(const std::size_t capacity)
+  {
+    if (!capacity || (capacity & (capacity - 1)))
+      throw std::invalid_argument{"spsc_ring capacity must be a power of 2"};
+    return capacity;
+  }
+
+public:
+  //! \throw std::invalid_argument if `capacity` is not a power of 2.
+  explicit spsc_ring(const std::size_t capacity)
+    : slots_(new T[check_capacity(capacity)]()),
+      mask_(capacity - 1),
+      head_(0),
+      tail_(0)
+  {}
+
+  spsc_ring(const spsc_ring&) = delete;
+  spsc_ring& operator=(const spsc_ring&) = delete;
+
+  std::size_t capacity() const noexcept { return mask_ + 1; }
+
+  //! \return Approximate number of filled slots. Safe from either thread.
+  std::size_t size() const noexcept
+  {
+    return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+  }
+
+  //! Consumer only. \return True if no slots are filled.
+  bool empty() const noexcept
+  {
+    return head_.load(std::memory_order_relaxed) == tail_.load(std::memory_order_acquire);
+  }
+
+  //! Producer only. \return Slot to fill, or `nullptr` if full.
+  T* back() noexcept
+  {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == capacity())
+      return nullptr;
+    return std::addressof(slots_[tail & mask_]);
+  }
+
+  //! Producer only. Publish the slot returned by `back()`.
+  void push() noexcept
+  {
+    tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  /*! Consumer only. Swaps the oldest filled slot with `out`, so the previous
+      contents of `out` are re-used by the producer.
+      \return False if empty. */
+  bool try_pop(T& out)
+  {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire))
+      return false;
+
+    using std::swap;
+    swap(out, slots_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+};
+
+#endif // MOTRIX_SPSC_RING_HPP
@@ -0,0 +1,124 @@
+// Copyright (c) 2020, Lee Clagett
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "stats.hpp"
+
+#include <ostream>
+
+namespace stats
+{
+  namespace
+  {
+    // constant initialized; safe to use from other static constructors
+    std::atomic<entry*> head{nullptr};
+  }
+
+  entry::entry(const char* name) noexcept
+    : name_(name), next_(head.exchange(this))
+  {}
+
+  void counter::print(std::ostream& out) const
+  {
+    out << name() << ": " << get();
+  }
+
+  void gauge::add(const std::uint64_t amount) noexcept
+  {
+    const std::uint64_t current = value_.fetch_add(amount, std::memory_order_relaxed) + amount;
+    std::uint64_t last = high_water_.load(std::memory_order_relaxed);
+    while (last < current && !high_water_.compare_exchange_weak(last, current, std::memory_order_relaxed))
+      ;
+  }
+
+  void gauge::set(const std::uint64_t value) noexcept
+  {
+    value_.store(value, std::memory_order_relaxed);
+    std::uint64_t last = high_water_.load(std::memory_order_relaxed);
+    while (last < value && !high_water_.compare_exchange_weak(last, value, std::memory_order_relaxed))
+      ;
+  }
+
+  void gauge::print(std::ostream& out) const
+  {
+    out << name() << ": " << get() << " (high-water " << high_water() << ')';
+  }
+
+  void latency::add(const std::chrono::steady_clock::duration elapsed) noexcept
+  {
+    const std::uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+
+    unsigned bucket = 0;
+    while (bucket < bucket_count - 1 && (std::uint64_t(1) << bucket) <= us)
+      ++bucket;
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    count_.fetch_add(1, std::memory_order_relaxed);
+    total_us_.fetch_add(us, std::memory_order_relaxed);
+
+    std::uint64_t last = max_us_.load(std::memory_order_relaxed);
+    while (last < us && !max_us_.compare_exchange_weak(last, us, std::memory_order_relaxed))
+      ;
+  }
+
+  std::uint64_t latency::percentile(const unsigned percent) const noexcept
+  {
+    std::uint64_t total = 0;
+    for (const auto& bucket : buckets_)
+      total += bucket.load(std::memory_order_relaxed);
+
+    const std::uint64_t target = (total * percent + 99) / 100;
+    std::uint64_t seen = 0;
+    for (unsigned i = 0; i < bucket_count; ++i)
+    {
+      seen += buckets_[i].load(std::memory_order_relaxed);
+      if (target && target <= seen)
+        return std::uint64_t(1) << i;
+    }
+    return 0;
+  }
+
+  void latency::print(std::ostream& out) const
+  {
+    const std::uint64_t count = count_.load(std::memory_order_relaxed);
+    const std::uint64_t total = total_us_.load(std::memory_order_relaxed);
+    out << name() << ": " << count << " calls, mean " << (count ? total / count : 0) <<
+      " us, p50 < " << percentile(50) << " us, p90 < " << percentile(90) <<
+      " us, p99 < " << percentile(99) << " us, max " <<
+      max_us_.load(std::memory_order_relaxed) << " us";
+  }
+
+  void print(std::ostream& out)
+  {
+    for (const entry* current = head.load(); current; current = current->next())
+    {
+      current->print(out);
+      out << '\n';
+    }
+    out.flush();
+  }
+}
@@ -0,0 +1,153 @@
+// Copyright (c) 2020, Lee Clagett
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOTRIX_STATS_HPP
+#define MOTRIX_STATS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+
+namespace stats
+{
+  /*! Base for a named statistic. Every instance is added to a global list at
+      construction, and is never removed. Therefore all instances must have
+      static storage duration. */
+  class entry
+  {
+    const char* const name_;
+    entry* const next_;
+
+  protected:
+    explicit entry(const char* name) noexcept;
+    ~entry() noexcept = default;
+
+  public:
+    entry(const entry&) = delete;
+    entry& operator=(const entry&) = delete;
+
+    //! \return Name provided at construction. Never `nullptr`.
+    const char* name() const noexcept { return name_; }
+
+    //! \return Next registered statistic, or `nullptr` if last.
+    const entry* next() const noexcept { return next_; }
+
+    //! Write the current value(s) of `this` statistic to `out`.
+    virtual void print(std::ostream& out) const = 0;
+  };
+
+  //! Monotonically increasing value; safe for concurrent updates.
+  class counter final : public entry
+  {
+    std::atomic<std::uint64_t> value_;
+
+  public:
+    explicit counter(const char* name) noexcept
+      : entry(name), value_(0)
+    {}
+
+    void add(const std::uint64_t amount) noexcept
+    {
+      value_.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    void increment() noexcept { add(1); }
+
+    std::uint64_t get() const noexcept
+    {
+      return value_.load(std::memory_order_relaxed);
+    }
+
+    virtual void print(std::ostream& out) const override final;
+  };
+
+  //! Current value and its maximum (high-water); safe for concurrent updates.
+  class gauge final : public entry
+  {
+    std::atomic<std::uint64_t> value_;
+    std::atomic<std::uint64_t> high_water_;
+
+  public:
+    explicit gauge(const char* name) noexcept
+      : entry(name), value_(0), high_water_(0)
+    {}
+
+    void add(std::uint64_t amount) noexcept;
+
+    //! Replace current value; high-water is updated if exceeded.
+    void set(std::uint64_t value) noexcept;
+
+    void subtract(const std::uint64_t amount) noexcept
+    {
+      value_.fetch_sub(amount, std::memory_order_relaxed);
+    }
+
+    std::uint64_t get() const noexcept
+    {
+      return value_.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t high_water() const noexcept
+    {
+      return high_water_.load(std::memory_order_relaxed);
+    }
+
+    virtual void print(std::ostream& out) const override final;
+  };
+
+  /*! Histogram of durations with power-of-two microsecond buckets, to show
+      tail latency. Also tracks count, mean and maximum. Safe for concurrent
+      updates. */
+  class latency final : public entry
+  {
+    static constexpr const unsigned bucket_count = 32; //!< Last is >= ~18 minutes
+
+    std::atomic<std::uint64_t> buckets_[bucket_count]; //!< [i] counts `< 2^i` us
+    std::atomic<std::uint64_t> count_;
+    std::atomic<std::uint64_t> total_us_;
+    std::atomic<std::uint64_t> max_us_;
+
+    //! \return Upper bound (us) of bucket containing `percent` of samples.
+    std::uint64_t percentile(unsigned percent) const noexcept;
+
+  public:
+    explicit latency(const char* name) noexcept
+      : entry(name), buckets_(), count_(0), total_us_(0), max_us_(0)
+    {}
+
+    void add(std::chrono::steady_clock::duration elapsed) noexcept;
+
+    virtual void print(std::ostream& out) const override final;
+  };
+
+  //! Write every registered statistic to `out`, one per line.
+  void print(std::ostream& out);
+}
+
+#endif // MOTRIX_STATS_HPP
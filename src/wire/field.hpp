@@ -29,18 +29,40 @@
 #ifndef MOTRIX_WIRE_FIELD_HPP
 #define MOTRIX_WIRE_FIELD_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <utility>
 
-//! 
+//! Hash of `name` is computed at compile time, for O(1) key lookup when reading.
 #define WIRE_FIELD(name)                          \
-  ::wire::field( #name , std::ref( self . name ))
+  ::wire::field< ::wire::key_hash( #name ) >( #name , std::ref( self . name ))
 
 //! Take the field name by value. Useful for write-only cheap copy types.
 #define WIRE_FIELD_COPY(name) \
-  ::wire::field( #name , self . name )
+  ::wire::field< ::wire::key_hash( #name ) >( #name , self . name )
+
+//! Field `name` (an identifier) with any `value`, e.g. a `visit_each` or a member not in `self`.
+#define WIRE_FIELD_NAMED(name, value) \
+  ::wire::field< ::wire::key_hash( #name ) >( #name , value )
 
 namespace wire
 {
+  /*! FNV-1a hash of `length` bytes at `name`. Recursive for C++11
+      `constexpr`, so only use on short strings; `json_reader` has an
+      iterative copy for keys read from input. */
+  constexpr std::uint32_t key_hash(const char* name, std::size_t length, std::uint32_t hash = 2166136261u) noexcept
+  {
+    return length ?
+      key_hash(name + 1, length - 1, std::uint32_t((hash ^ std::uint8_t(*name)) * 16777619u)) : hash;
+  }
+
+  //! \return `key_hash` of string literal `name`, without the null terminator.
+  template<std::size_t N>
+  constexpr std::uint32_t key_hash(const char (&name)[N]) noexcept
+  {
+    return key_hash(name, N - 1);
+  }
+
   template<typename T>
   struct unwrap_reference
   {
@@ -54,13 +76,17 @@ namespace wire
   };
 
 
-  //! Links `name` to a `value` for object serialization.
-  template<typename T>
+  /*! Links `name` to a `value` for object serialization. `Hash` is part of
+      the type, so readers can build key tables once per set of fields. */
+  template<typename T, std::uint32_t Hash>
   struct field_
   {
     using value_type = typename unwrap_reference<T>::type;
 
+    static constexpr const std::uint32_t name_hash = Hash; //!< `key_hash(name, name_length)`
+
     char const* const name;
+    const std::size_t name_length;
     T value;
 
     //! \return `value` with `std::reference_wrapper` removed.
@@ -76,11 +102,15 @@ namespace wire
     }
   };
 
-  //! Links `name` to `value`. Use `std::ref` if de-serializing.
-  template<typename T>
-  constexpr inline field_<T> field(const char* name, T value)
+  template<typename T, std::uint32_t Hash>
+  constexpr const std::uint32_t field_<T, Hash>::name_hash;
+
+  /*! Links string literal `name` to `value`, with `Hash` precomputed by
+      `WIRE_FIELD`. Use `std::ref` if de-serializing. */
+  template<std::uint32_t Hash, std::size_t N, typename T>
+  constexpr inline field_<T, Hash> field(const char (&name)[N], T value)
   {
-    return {name, std::move(value)};
+    return {name, N - 1, std::move(value)};
   }
 
   // example usage : `wire::sum(std::size_t(wire::available(fields))...)`
@@ -29,9 +29,12 @@
 #ifndef MOTRIX_WIRE_JSON_BASE_HPP
 #define MOTRIX_WIRE_JSON_BASE_HPP
 
+#include "byte_rope.hpp"
 #include "byte_slice.hpp"
 #include "wire/json/fwd.hpp"
 
+template<typename> class expect;
+
 namespace wire
 {
   struct json
@@ -40,7 +43,16 @@ namespace wire
     using output_type = json_writer;
 
     template<typename T>
-    static T from_bytes(byte_slice source);
+    static T from_bytes(byte_rope source);
+
+    //! Same as `from_bytes`, but never throws on malformed input.
+    template<typename T>
+    static expect<T> try_from_bytes(byte_rope source);
+
+    /*! Decode many messages through the same `context`, and into the same
+        `dest`, to re-use their buffers. */
+    template<typename T>
+    static expect<void> try_from_bytes(byte_rope source, T& dest, json_reader& context);
 
     template<typename T>
     static byte_slice to_bytes(const T& source);
@@ -29,6 +29,9 @@
 #include "wire/json/read.hpp"
 
 #include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
 #include <rapidjson/memorystream.h>
 #include <stdexcept>
 
@@ -36,289 +39,766 @@
 #include "hex.hpp"
 #include "wire/error.hpp"
 #include "wire/json/error.hpp"
+#include "wire/json/skip.hpp"
 
 namespace
 {
   //! Maximum number of bytes to display "near" JSON error.
   constexpr const std::size_t snippet_size = 30;
 
+  //! Per-thread reader lent by `wire::json_context`
+  thread_local wire::json_reader thread_reader{};
+  thread_local bool thread_reader_used = false;
+
   //! Maximum depth for both objects and arrays before erroring
   constexpr const std::size_t max_json_read_depth = 100;
 
+  //! Minimum bytes copied from next segment when a token straddles segments
+  constexpr const std::size_t min_join_size = 64;
+
+  //! Iterative `wire::key_hash`, safe for keys of any length.
+  std::uint32_t hash_key(const char* key, const std::size_t length) noexcept
+  {
+    std::uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < length; ++i)
+      hash = (hash ^ std::uint8_t(key[i])) * 16777619u;
+    return hash;
+  }
+
+  /*! \return Index in `source` of the quote closing the string that opens
+        at `source[0]`, or `source.size()`. `escaped` is set if a backslash
+        precedes it. */
+  std::size_t string_end(const span<const std::uint8_t> source, bool& escaped) noexcept
+  {
+    if (source.size() < 2)
+      return source.size();
+
+    // common case: memchr is vectorized, and keys/hex have no escapes
+    const std::uint8_t* const begin = source.data() + 1;
+    const std::size_t length = source.size() - 1;
+    void const* const quote = std::memchr(begin, '"', length);
+    const std::size_t until = quote ? static_cast<const std::uint8_t*>(quote) - begin : length;
+    if (!std::memchr(begin, '\\', until))
+      return quote ? until + 1 : source.size();
+
+    escaped = true;
+    for (std::size_t i = 1; i < source.size(); ++i)
+    {
+      if (source[i] == '"')
+        return i;
+      if (source[i] == '\\')
+        ++i;
+    }
+    return source.size();
+  }
+
+  //! \return Value of hex `digit`, or -1.
+  int hex_digit(const std::uint8_t digit) noexcept
+  {
+    if ('0' <= digit && digit <= '9')
+      return digit - '0';
+    if ('a' <= digit && digit <= 'f')
+      return digit - 'a' + 10;
+    if ('A' <= digit && digit <= 'F')
+      return digit - 'A' + 10;
+    return -1;
+  }
+
+  void append_utf8(std::string& dest, const std::uint32_t code)
+  {
+    if (code < 0x80)
+      dest.push_back(char(code));
+    else if (code < 0x800)
+    {
+      dest.push_back(char(0xC0 | (code >> 6)));
+      dest.push_back(char(0x80 | (code & 0x3F)));
+    }
+    else if (code < 0x10000)
+    {
+      dest.push_back(char(0xE0 | (code >> 12)));
+      dest.push_back(char(0x80 | ((code >> 6) & 0x3F)));
+      dest.push_back(char(0x80 | (code & 0x3F)));
+    }
+    else
+    {
+      dest.push_back(char(0xF0 | (code >> 18)));
+      dest.push_back(char(0x80 | ((code >> 12) & 0x3F)));
+      dest.push_back(char(0x80 | ((code >> 6) & 0x3F)));
+      dest.push_back(char(0x80 | (code & 0x3F)));
+    }
+  }
+
+  //! \return First slot to probe for `hash`. Mixes high bits into the low bits used by `mask`.
+  std::size_t key_slot(const std::uint32_t hash, const std::size_t mask) noexcept
+  {
+    return (hash ^ (hash >> 16)) & mask;
+  }
+
+  /*! Objects with at most this many fields compare key lengths first,
+      instead of hashing; a length mismatch rejects a field without reading
+      the key, which beats hashing every key of small field sets. */
+  constexpr const std::size_t max_linear_keys = 4;
+
+  constexpr const char true_literal[] = {'t', 'r', 'u', 'e'};
+  constexpr const char false_literal[] = {'f', 'a', 'l', 's', 'e'};
+  constexpr const char null_literal[] = {'n', 'u', 'l', 'l'};
+
+  //! \return Length of the run of number characters at the start of `source`.
+  std::size_t number_length(const span<const std::uint8_t> source) noexcept
+  {
+    std::size_t i = 0;
+    for (; i < source.size(); ++i)
+    {
+      const std::uint8_t c = source[i];
+      if (!(('0' <= c && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E'))
+        break;
+    }
+    return i;
+  }
+
+  bool is_digit(const span<const std::uint8_t> source, const std::size_t i) noexcept
+  {
+    return i < source.size() && '0' <= source[i] && source[i] <= '9';
+  }
+
+  /*! Check that all of `token` is a JSON number, and read its integer
+      magnitude. \return `kParseErrorNone` if valid. */
+  rapidjson::ParseErrorCode parse_number(const span<const std::uint8_t> token, wire::json_reader::number& out) noexcept
+  {
+    std::size_t i = 0;
+    out.negative = (i < token.size() && token[i] == '-');
+    i += out.negative;
+
+    if (!is_digit(token, i))
+      return rapidjson::kParseErrorValueInvalid;
+    if (token[i] == '0')
+      ++i;
+    else
+    {
+      constexpr const std::uintmax_t max = std::numeric_limits<std::uintmax_t>::max();
+      for (; is_digit(token, i); ++i)
+      {
+        const unsigned digit = token[i] - '0';
+        if ((max - digit) / 10 < out.magnitude)
+          out.overflow = true;
+        out.magnitude = out.magnitude * 10 + digit;
+      }
+    }
+
+    if (i < token.size() && token[i] == '.')
+    {
+      out.fraction = true;
+      if (!is_digit(token, ++i))
+        return rapidjson::kParseErrorNumberMissFraction;
+      while (is_digit(token, i))
+        ++i;
+    }
+
+    if (i < token.size() && (token[i] == 'e' || token[i] == 'E'))
+    {
+      out.fraction = true;
+      ++i;
+      if (i < token.size() && (token[i] == '+' || token[i] == '-'))
+        ++i;
+      if (!is_digit(token, i))
+        return rapidjson::kParseErrorNumberMissExponent;
+      while (is_digit(token, i))
+        ++i;
+    }
+
+    return i == token.size() ? rapidjson::kParseErrorNone : rapidjson::kParseErrorValueInvalid;
+  }
+
+  //! \return Index of first non-whitespace byte in `source` at or after `i`.
+  std::size_t skip_space(const span<const std::uint8_t> source, std::size_t i) noexcept
+  {
+    for (; i < source.size(); ++i)
+    {
+      switch (source[i])
+      {
+      case ' ':
+      case '\t':
+      case '\n':
+      case '\r':
+        break;
+      default:
+        return i;
+      }
+    }
+    return i;
+  }
+
   struct json_default_reject : rapidjson::BaseReaderHandler<rapidjson::UTF8<>, json_default_reject>
   {
     bool Default() const noexcept { return false; }
   };
 
-  //! \throw std::system_error by converting `code` into a std::error_code
-  [[noreturn]] void throw_json_error(const rapidjson::Reader& reader, const wire::error::schema expected)
+  //! \return rapidjson error from `reader`, or `expected` if the handler rejected the value.
+  std::error_code json_error(const rapidjson::Reader& reader, const wire::error::schema expected) noexcept
   {
     const rapidjson::ParseErrorCode parse_error = reader.GetParseErrorCode();
     switch (parse_error)
     {
     default:
-      MOT_THROW(wire::error::rapidjson_e(parse_error), nullptr);
+      return wire::error::rapidjson_e(parse_error);
     case rapidjson::kParseErrorNone:
     case rapidjson::kParseErrorTermination: // the handler returned false
       break;
     }
-
-    MOT_THROW(expected, nullptr);
+    return expected;
   }
 }
 
 namespace wire
 {
+  //! Only used for doubles; every other token is read natively.
   struct json_reader::rapidjson_sax
   {
-    struct string_contents
+    double number;
+
+    bool Null() const noexcept { return false; }
+    bool Bool(bool) const noexcept { return false; }
+    bool Int(const int i) noexcept { return Double(i); }
+    bool Uint(const unsigned i) noexcept { return Double(i); }
+    bool Int64(const std::int64_t i) noexcept { return Double(double(i)); }
+    bool Uint64(const std::uint64_t i) noexcept { return Double(double(i)); }
+    bool Double(const double i) noexcept
     {
-       const char* ptr;
-       std::size_t length;
-    };
+      number = i;
+      return true;
+    }
+    bool RawNumber(const char*, std::size_t, bool) const noexcept { return false; }
+    bool String(const char*, std::size_t, bool) const noexcept { return false; }
+    bool Key(const char*, std::size_t, bool) const noexcept { return false; }
+    bool StartArray() const noexcept { return false; }
+    bool EndArray(std::size_t) const noexcept { return false; }
+    bool StartObject() const noexcept { return false; }
+    bool EndObject(std::size_t) const noexcept { return false; }
+  };
 
-    std::string* temp_str;
-    union
-    {
-      bool boolean;
-      std::intmax_t integer;
-      std::uintmax_t unsigned_integer;
-      double number;
-      string_contents string;
-    } value;
+  void json_reader::increment_depth() noexcept
+  {
+    if (++depth_ == max_json_read_depth)
+      fail(error::schema::maximum_depth);
+  }
 
-    error::schema expected_;
-    bool negative;
+  void json_reader::next_segment() noexcept
+  {
+    assert(current_.empty() && has_more());
+    const byte_slice& next = source_.segment(next_segment_);
+    current_ = {next.data() + pending_, next.size() - pending_};
+    ++next_segment_;
+    pending_ = 0;
+  }
 
-    rapidjson_sax(error::schema expected, std::string* temp_str = nullptr) noexcept
-      : temp_str(temp_str), expected_(expected), negative(false)
-    {}
+  void json_reader::join_segments()
+  {
+    assert(has_more());
+    const byte_slice& next = source_.segment(next_segment_);
+    const std::size_t added =
+      std::min(next.size() - pending_, std::max(min_join_size, current_.size()));
 
-    bool Null() const noexcept
+    // re-use capacity of `joined_`; `current_` may already point into it
+    if (!joined_.empty() && joined_.data() <= current_.data() && current_.data() < joined_.data() + joined_.size())
     {
-      return expected_ == error::schema::none;
+      std::memmove(joined_.data(), current_.data(), current_.size());
+      joined_.resize(current_.size());
     }
+    else
+      joined_.assign(current_.begin(), current_.end());
+    joined_.insert(joined_.end(), next.data() + pending_, next.data() + pending_ + added);
 
-    bool Bool(bool i) noexcept
+    current_ = {joined_.data(), joined_.size()};
+    pending_ += added;
+    if (pending_ == next.size())
     {
-      value.boolean = i;
-      return expected_ == error::schema::boolean || expected_ == error::schema::none;
+      ++next_segment_;
+      pending_ = 0;
     }
+  }
 
-    bool Int(int i) noexcept
+  bool json_reader::read_next_value(rapidjson_sax& handler)
+  {
+    if (failed())
+      return false;
+
+    get_next_token();
+    for (;;)
     {
-      return Int64(i);
+      rapidjson::MemoryStream stream{reinterpret_cast<const char*>(current_.data()), current_.size()};
+      const bool parsed = reader_.Parse<rapidjson::kParseStopWhenDoneFlag>(stream, handler);
+
+      // value at the end of `current_` (or error) might be a split token
+      if (has_more() && (!parsed || stream.Tell() == current_.size()))
+        join_segments();
+      else
+      {
+        if (!parsed)
+        {
+          fail(json_error(reader_, error::schema::number));
+          return false;
+        }
+        current_.remove_prefix(stream.Tell());
+        return true;
+      }
     }
-    bool Uint(unsigned i) noexcept
+  }
+
+  char json_reader::get_next_token() noexcept
+  {
+    for (;;)
     {
-      return Uint64(i);
+      current_.remove_prefix(skip_space(current_, 0));
+      if (!current_.empty())
+        return char(current_[0]);
+      if (!has_more())
+        return 0;
+      next_segment();
     }
-    bool Int64(std::int64_t i) noexcept
+  }
+
+  span<const std::uint8_t> json_reader::get_next_number()
+  {
+    for (;;)
     {
-      negative = true;
-      switch(expected_)
+      const std::size_t length = number_length(current_);
+      if (length < current_.size() || !has_more())
       {
-      default:
-        return false;
-      case error::schema::integer:
-        value.integer = i;
-        break;
-      case error::schema::number:
-        value.number = i;
-        break;
-      case error::schema::none:
-        break;
+        const span<const std::uint8_t> out{current_.data(), length};
+        current_.remove_prefix(length);
+        return out;
       }
+      join_segments();
+    }
+  }
+
+  bool json_reader::read_number(number& out)
+  {
+    const rapidjson::ParseErrorCode error = parse_number(get_next_number(), out);
+    if (error == rapidjson::kParseErrorNone)
       return true;
+    fail(error::rapidjson_e(error));
+    return false;
+  }
+
+  bool json_reader::literal(const span<const char> text)
+  {
+    while (current_.size() < text.size() && has_more())
+      join_segments();
+    if (current_.size() < text.size() || std::memcmp(current_.data(), text.data(), text.size()) != 0)
+    {
+      fail(error::rapidjson_e(rapidjson::kParseErrorValueInvalid));
+      return false;
+    }
+    current_.remove_prefix(text.size());
+    return true;
+  }
+
+  void json_reader::wrong_type(const char next, const error::schema expected) noexcept
+  {
+    switch (next)
+    {
+    case 0:
+      return fail(error::rapidjson_e(rapidjson::kParseErrorDocumentEmpty));
+    case '"':
+    case '{':
+    case '[':
+    case 't':
+    case 'f':
+    case 'n':
+    case '-':
+    case '0': case '1': case '2': case '3': case '4':
+    case '5': case '6': case '7': case '8': case '9':
+      return fail(expected);
+    default:
+      return fail(error::rapidjson_e(rapidjson::kParseErrorValueInvalid));
     }
-    bool Uint64(std::uint64_t i) noexcept
+  }
+
+  bool json_reader::unescape(const span<const std::uint8_t> source)
+  {
+    temp_str_.clear();
+    for (std::size_t i = 0; i < source.size(); ++i)
     {
-      switch (expected_)
+      const char c = char(source[i]);
+      if (c != '\\')
       {
-      default:
-        return false;
-      case error::schema::integer:
-        value.unsigned_integer = i;
+        temp_str_.push_back(c);
+        continue;
+      }
+
+      // `source` never ends with an unescaped backslash
+      switch (source[++i])
+      {
+      case '"':
+      case '\\':
+      case '/':
+        temp_str_.push_back(char(source[i]));
+        break;
+      case 'b':
+        temp_str_.push_back('\b');
+        break;
+      case 'f':
+        temp_str_.push_back('\f');
+        break;
+      case 'n':
+        temp_str_.push_back('\n');
         break;
-      case error::schema::number:
-        value.number = i;
+      case 'r':
+        temp_str_.push_back('\r');
         break;
-      case error::schema::none:
+      case 't':
+        temp_str_.push_back('\t');
+        break;
+      case 'u':
+      {
+        std::uint32_t code = 0;
+        if (!read_escaped_code(source, i, code))
+          return false;
+        if (0xDC00 <= code && code <= 0xDFFF)
+        {
+          fail(error::rapidjson_e(rapidjson::kParseErrorStringUnicodeSurrogateInvalid));
+          return false;
+        }
+        if (0xD800 <= code && code <= 0xDBFF)
+        {
+          std::uint32_t low = 0;
+          if (source.size() - i < 7 || source[i + 1] != '\\' || source[i + 2] != 'u')
+          {
+            fail(error::rapidjson_e(rapidjson::kParseErrorStringUnicodeSurrogateInvalid));
+            return false;
+          }
+          i += 2;
+          if (!read_escaped_code(source, i, low))
+            return false;
+          if (low < 0xDC00 || 0xDFFF < low)
+          {
+            fail(error::rapidjson_e(rapidjson::kParseErrorStringUnicodeSurrogateInvalid));
+            return false;
+          }
+          code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        }
+        append_utf8(temp_str_, code);
         break;
       }
-      return true;
-    }
-
-    bool Double(double i) noexcept
-    {
-      value.number = i;
-      return expected_ == error::schema::number || expected_ == error::schema::none;
+      default:
+        fail(error::rapidjson_e(rapidjson::kParseErrorStringEscapeInvalid));
+        return false;
+      }
     }
+    return true;
+  }
 
-    bool RawNumber(const char*, std::size_t, bool) const noexcept
+  bool json_reader::read_escaped_code(const span<const std::uint8_t> source, std::size_t& i, std::uint32_t& code)
+  {
+    // `i` is at the `u`
+    if (source.size() - i <= 4)
     {
+      fail(error::rapidjson_e(rapidjson::kParseErrorStringUnicodeEscapeInvalidHex));
       return false;
     }
-
-    bool String(const char* str, const std::size_t length, const bool copy) noexcept
+    for (std::size_t end = i + 4; i < end; )
     {
-      if (expected_ == error::schema::string)
+      const int digit = hex_digit(source[++i]);
+      if (digit < 0)
       {
-	if (copy)
-	{
-	  if (!temp_str)
-	    return false;
-	  temp_str->assign(str, length);
-	  str = temp_str->c_str();
-	}
-	value.string = {str, length};
-	return true;
+        fail(error::rapidjson_e(rapidjson::kParseErrorStringUnicodeEscapeInvalidHex));
+        return false;
       }
-      return expected_ == error::schema::none;
+      code = (code << 4) | unsigned(digit);
     }
-    bool Key(const char* str, const std::size_t length, const bool copy)
+    return true;
+  }
+
+  span<const char> json_reader::string_view()
+  {
+    if (get_next_token() != '"')
     {
-      return String(str, length, copy);
+      fail(error::schema::string);
+      return {};
     }
 
-    bool StartArray() const noexcept { return expected_ == error::schema::none; }
-    bool EndArray(std::size_t) const noexcept { return expected_ == error::schema::none; }
-    bool StartObject() const noexcept { return expected_ == error::schema::none; }
-    bool EndObject(std::size_t) const noexcept { return expected_ == error::schema::none; }
-  };
+    // whole string must be in `current_`, so the zero-copy view is contiguous
+    std::size_t end = 0;
+    bool escaped = false;
+    while ((end = string_end(current_, escaped)) == current_.size())
+    {
+      if (!has_more())
+      {
+        fail(error::rapidjson_e(rapidjson::kParseErrorStringMissQuotationMark));
+        return {};
+      }
+      join_segments();
+    }
 
-  void json_reader::increment_depth()
-  {
-    if (++depth_ == max_json_read_depth)
-      MOT_THROW(error::schema::maximum_depth, nullptr);
+    const span<const std::uint8_t> contents{current_.data() + 1, end - 1};
+    current_.remove_prefix(end + 1);
+    if (!escaped)
+      return {reinterpret_cast<const char*>(contents.data()), contents.size()};
+    if (!unescape(contents))
+      return {};
+    return {temp_str_.data(), temp_str_.size()};
   }
 
-  void json_reader::read_next_value(rapidjson_sax& handler)
+  byte_slice json_reader::string_slice()
   {
-    rapidjson::MemoryStream stream{reinterpret_cast<const char*>(current_.data()), current_.size()};
-    if (!reader_.Parse<rapidjson::kParseStopWhenDoneFlag>(stream, handler))
-      throw_json_error(reader_, handler.expected_);
-    current_.remove_prefix(stream.Tell());
-  }
+    const span<const char> view = string_view();
+    if (failed())
+      return nullptr;
 
-  char json_reader::get_next_token()
-  {
-    rapidjson::MemoryStream stream{reinterpret_cast<const char*>(current_.data()), current_.size()};
-    rapidjson::SkipWhitespace(stream);
-    current_.remove_prefix(stream.Tell());
-    return stream.Peek();
+    // reference count the source segment when `view` points into it
+    if (next_segment_)
+    {
+      const byte_slice& segment = source_.segment(next_segment_ - 1);
+      const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(segment.data());
+      const std::uintptr_t start = reinterpret_cast<std::uintptr_t>(view.data());
+      if (begin <= start && start - begin <= segment.size() && view.size() <= segment.size() - (start - begin))
+        return segment.get_slice(start - begin, start - begin + view.size());
+    }
+    return byte_slice{{span<const std::uint8_t>{reinterpret_cast<const std::uint8_t*>(view.data()), view.size()}}};
   }
 
-  span<const char> json_reader::get_next_string()
+  void json_reader::skip_value()
   {
-    if (get_next_token() != '"')
-      MOT_THROW(error::schema::string, nullptr);
-    current_.remove_prefix(1);
-
-    void const* const end = std::memchr(current_.data(), '"', current_.size());
-    if (!end)
-      MOT_THROW(error::rapidjson_e(rapidjson::kParseErrorStringMissQuotationMark), nullptr);
+    const char next = get_next_token();
+    if (failed())
+      return;
+    // numbers and literals are short, and still validated
+    switch (next)
+    {
+    case '{':
+    case '[':
+    case '"':
+      break;
+    case 't':
+      literal(true_literal);
+      return;
+    case 'f':
+      literal(false_literal);
+      return;
+    case 'n':
+      literal(null_literal);
+      return;
+    default:
+      if (next == '-' || ('0' <= next && next <= '9'))
+      {
+        number ignored{};
+        read_number(ignored);
+      }
+      else
+        wrong_type(next, error::schema::none);
+      return;
+    }
 
-    char const* const begin = reinterpret_cast<const char*>(current_.data());
-    const std::size_t length = current_.remove_prefix(static_cast<const std::uint8_t*>(end) - current_.data() + 1);
-    return {begin, length - 1};
+    // scanner state carries across segments, so nothing is joined
+    skip_state state{};
+    for (;;)
+    {
+      current_.remove_prefix(skip_json(state, current_));
+      if (state.done)
+        return;
+      if (state.error)
+        return fail(state.error);
+      if (!has_more())
+      {
+        if (state.in_string)
+          return fail(error::rapidjson_e(rapidjson::kParseErrorStringMissQuotationMark));
+        const bool object = (state.objects[(state.depth - 1) / 64] >> ((state.depth - 1) % 64)) & 1;
+        return fail(error::rapidjson_e(
+          object ? rapidjson::kParseErrorObjectMissCommaOrCurlyBracket : rapidjson::kParseErrorArrayMissCommaOrSquareBracket
+        ));
+      }
+      next_segment();
+    }
   }
 
-  void json_reader::skip_value()
-  {
-    rapidjson_sax accept_all{error::schema::none};
-    read_next_value(accept_all);
-  }
+  json_reader::json_reader()
+    : json_reader(byte_rope{})
+  {}
 
-  json_reader::json_reader(byte_slice source)
+  json_reader::json_reader(byte_rope source)
     : source_(std::move(source)),
-      current_(source_.data(), source_.size()),
+      current_(),
+      joined_(),
       temp_str_(),
+      next_segment_(0),
+      pending_(0),
       depth_(0),
+      error_(),
+      error_detail_(nullptr),
       reader_()
   {}
 
-  void json_reader::check_complete() const
+  void json_reader::reset(byte_rope source) noexcept
+  {
+    source_ = std::move(source);
+    current_ = nullptr;
+    next_segment_ = 0;
+    pending_ = 0;
+    depth_ = 0;
+    error_ = std::error_code{};
+    error_detail_ = nullptr;
+  }
+
+  void json_reader::fail(const std::error_code code, const char* const detail) noexcept
+  {
+    if (failed())
+      return;
+    error_ = code;
+    error_detail_ = detail;
+
+    // every later token read sees end of input
+    current_ = nullptr;
+    next_segment_ = source_.segments();
+  }
+
+  void json_reader::throw_if_failed() const
+  {
+    if (failed())
+      MOT_THROW(error_, error_detail_);
+  }
+
+  void json_reader::check_complete() noexcept
   {
     if (depth())
-      MOT_THROW(error::rapidjson_e(rapidjson::kParseErrorUnspecificSyntaxError), "Unexpected end");
+      fail(error::rapidjson_e(rapidjson::kParseErrorUnspecificSyntaxError), "Unexpected end");
   }
 
   bool json_reader::boolean()
   {
-    rapidjson_sax json_bool{error::schema::boolean};
-    read_next_value(json_bool);
-    return json_bool.value.boolean;
+    const char next = get_next_token();
+    if (next == 't')
+      return literal(true_literal);
+    if (next == 'f')
+      literal(false_literal);
+    else
+      wrong_type(next, error::schema::boolean);
+    return false;
   }
 
   std::intmax_t json_reader::integer()
   {
-    rapidjson_sax json_int{error::schema::integer};
-    read_next_value(json_int);
-    if (json_int.negative)
-      return json_int.value.integer;
-    return integer::convert_to<std::intmax_t>(json_int.value.unsigned_integer);
+    number value{};
+    if (!read_integer(value))
+      return 0;
+    if (!value.negative)
+      return check(integer::convert_to<std::intmax_t>(value.magnitude));
+    if (!value.magnitude)
+      return 0;
+    if (std::uintmax_t(std::numeric_limits<std::intmax_t>::max()) < value.magnitude - 1)
+    {
+      fail(error::schema::integer); // a double in rapidjson
+      return 0;
+    }
+    return -std::intmax_t(value.magnitude - 1) - 1;
   }
 
   std::uintmax_t json_reader::unsigned_integer()
   {
-    rapidjson_sax json_uint{error::schema::integer};
-    read_next_value(json_uint);
-    if (!json_uint.negative)
-      return json_uint.value.unsigned_integer;
-    return integer::convert_to<std::uintmax_t>(json_uint.value.integer);
+    number value{};
+    if (!read_integer(value))
+      return 0;
+    if (value.negative && value.magnitude)
+    {
+      fail(error::schema::larger_integer);
+      return 0;
+    }
+    return value.magnitude;
+  }
+
+  bool json_reader::read_integer(number& out)
+  {
+    const char next = get_next_token();
+    if (next != '-' && (next < '0' || '9' < next))
+    {
+      wrong_type(next, error::schema::integer);
+      return false;
+    }
+    if (!read_number(out))
+      return false;
+    if (out.fraction || out.overflow)
+    {
+      fail(error::schema::integer);
+      return false;
+    }
+    return true;
   }
 
   double json_reader::real()
   {
-    rapidjson_sax json_number{error::schema::number};
-    read_next_value(json_number);
-    return json_number.value.number;
+    // rapidjson still does the decimal to binary conversion
+    rapidjson_sax json_number{};
+    if (!read_next_value(json_number))
+      return 0;
+    return json_number.number;
   }
 
   std::string json_reader::string()
   {
-    rapidjson_sax json_string{error::schema::string, std::addressof(temp_str_)};
-    read_next_value(json_string);
-    return std::string{json_string.value.string.ptr, json_string.value.string.length};
+    const span<const char> value = string_view();
+    return std::string{value.data(), value.size()};
   }
 
   void json_reader::binary(span<std::uint8_t> dest)
   {
-    const span<const char> value = get_next_string();
-    if (!from_hex::to_buffer(dest, value))
-      MOT_THROW(error::schema::fixed_binary, ("of size" + std::to_string(dest.size() * 2) + " but got " + std::to_string(value.size())).c_str());
+    // hex has no escapes; the closing quote must be right after `dest.size() * 2` digits
+    const std::size_t length = dest.size() * 2;
+    const char next = get_next_token();
+    if (next != '"')
+      return wrong_type(next, error::schema::string);
+
+    while (current_.size() < length + 2 && has_more())
+      join_segments();
+
+    if (current_.size() < length + 2 || current_[length + 1] != '"' ||
+        !from_hex::to_buffer(dest, {reinterpret_cast<const char*>(current_.data()) + 1, length}))
+    {
+      // re-read as a string, so the correct error is reported
+      const span<const char> value = string_view();
+      if (!failed() && !from_hex::to_buffer(dest, value))
+        fail(error::schema::fixed_binary);
+      return;
+    }
+    current_.remove_prefix(length + 2);
   }
 
   std::size_t json_reader::enumeration(span<char const* const> enums)
   {
-    rapidjson_sax json_enum{error::schema::string, std::addressof(temp_str_)};
-    read_next_value(json_enum);
+    const span<const char> value = string_view();
+    if (failed())
+      return enums.size();
 
     for (std::size_t i = 0; i < enums.size(); ++i)
     {
       const std::size_t current_length = std::strlen(enums[i]);
-      if (json_enum.value.string.length == current_length && std::memcmp(json_enum.value.string.ptr, enums[i], current_length) == 0)
+      if (value.size() == current_length && std::memcmp(value.data(), enums[i], current_length) == 0)
         return i;
     }
 
-    MOT_THROW(error::schema::enumeration, (std::string{json_enum.value.string.ptr} + " is not a valid enum").c_str());
+    fail(error::schema::enumeration);
     return enums.size();
   }
 
   void json_reader::start_array()
   {
-    if (get_next_token() != '[')
-      MOT_THROW(error::schema::array, nullptr);
-    current_.remove_prefix(1);
+    // depth always changes, `end_array` is still called on failure
+    if (get_next_token() == '[')
+      current_.remove_prefix(1);
+    else
+      fail(error::schema::array);
     increment_depth();
   }
 
   bool json_reader::is_array_end(const std::size_t count)
   {
     const char next = get_next_token();
+    if (failed())
+      return true;
     if (next == 0)
-      MOT_THROW(error::rapidjson_e(rapidjson::kParseErrorArrayMissCommaOrSquareBracket), nullptr);
+    {
+      fail(error::rapidjson_e(rapidjson::kParseErrorArrayMissCommaOrSquareBracket));
+      return true;
+    }
     if (next == ']')
     {
       current_.remove_prefix(1);
@@ -328,7 +808,10 @@ namespace wire
     if (count)
     {
       if (next != ',')
-        MOT_THROW(error::rapidjson_e(rapidjson::kParseErrorArrayMissCommaOrSquareBracket), nullptr);
+      {
+        fail(error::rapidjson_e(rapidjson::kParseErrorArrayMissCommaOrSquareBracket));
+        return true;
+      }
       current_.remove_prefix(1);
     }
     return false;
@@ -336,33 +819,100 @@ namespace wire
 
   void json_reader::start_object()
   {
-    if (get_next_token() != '{')
-      MOT_THROW(error::schema::object, nullptr);
-    current_.remove_prefix(1);
+    // depth always changes, `end_object` is still called on failure
+    if (get_next_token() == '{')
+      current_.remove_prefix(1);
+    else
+      fail(error::schema::object);
     increment_depth();
   }
 
-  bool json_reader::key(const span<const key_map> map, std::size_t count, std::size_t& index)
+  void json_reader::index_keys(const span<const std::uint32_t> hashes, span<std::uint8_t> slots) noexcept
+  {
+    assert(hashes.size() * 2 <= slots.size() && (slots.size() & (slots.size() - 1)) == 0);
+    const std::size_t mask = slots.size() - 1;
+    for (std::size_t i = 0; i < hashes.size(); ++i)
+    {
+      std::size_t slot = key_slot(hashes[i], mask);
+      while (slots[slot])
+        slot = (slot + 1) & mask;
+      slots[slot] = std::uint8_t(i + 1);
+    }
+  }
+
+  std::size_t json_reader::find_key(const span<const key_map> map, const span<const std::uint8_t> slots, const span<const char> name) noexcept
   {
-    rapidjson_sax json_key{error::schema::string, std::addressof(temp_str_)};
-    const auto process_key = [map] (const rapidjson_sax::string_contents value)
+    if (map.size() <= max_linear_keys)
     {
       for (std::size_t i = 0; i < map.size(); ++i)
       {
-	const std::size_t current_length = std::strlen(map[i].name);
-        if (value.length == current_length && std::memcmp(value.ptr, map[i].name, current_length) == 0)
+        if (map[i].length == name.size() && std::memcmp(name.data(), map[i].name, name.size()) == 0)
           return i;
       }
       return map.size();
-    };
+    }
+
+    // table is at most half full, so an empty slot always ends the probe
+    const std::uint32_t hash = hash_key(name.data(), name.size());
+    const std::size_t mask = slots.size() - 1;
+    for (std::size_t slot = key_slot(hash, mask); slots[slot]; slot = (slot + 1) & mask)
+    {
+      const key_map& entry = map[slots[slot] - 1];
+      if (entry.hash == hash && entry.length == name.size() && std::memcmp(name.data(), entry.name, name.size()) == 0)
+        return std::size_t(slots[slot] - 1);
+    }
+    return map.size();
+  }
+
+  bool json_reader::is_object_end()
+  {
+    if (get_next_token() != '}')
+      return false;
+    current_.remove_prefix(1);
+    return true;
+  }
+
+  bool json_reader::ordered_key(const char* name, const std::size_t length, const std::size_t count)
+  {
+    // only matches within `current_`; a key split across segments or using escapes is left to `key`
+    std::size_t i = 0;
+    if (count)
+    {
+      if (get_next_token() != ',')
+        return false;
+      i = skip_space(current_, 1);
+    }
+    else
+      get_next_token();
+
+    if (current_.size() - i < length + 2 || current_[i] != '"')
+      return false;
+    ++i;
+    if (std::memcmp(current_.data() + i, name, length) != 0 || current_[i + length] != '"')
+      return false;
+
+    i = skip_space(current_, i + length + 1);
+    if (i == current_.size() || current_[i] != ':')
+      return false;
+
+    current_.remove_prefix(i + 1);
+    return true;
+  }
 
+  bool json_reader::key(const span<const key_map> map, const span<const std::uint8_t> slots, std::size_t count, std::size_t& index)
+  {
     index = map.size();
     for (;;)
     {
       // check for object or text end
       const char next = get_next_token();
+      if (failed())
+        return false;
       if (next == 0)
-        MOT_THROW(error::rapidjson_e(rapidjson::kParseErrorObjectMissCommaOrCurlyBracket), nullptr);
+      {
+        fail(error::rapidjson_e(rapidjson::kParseErrorObjectMissCommaOrCurlyBracket));
+        return false;
+      }
       if (next == '}')
       {
         current_.remove_prefix(1);
@@ -373,16 +923,24 @@ namespace wire
       if (count)
       {
         if (next != ',')
-          MOT_THROW(error::rapidjson_e(rapidjson::kParseErrorObjectMissCommaOrCurlyBracket), nullptr);
+        {
+          fail(error::rapidjson_e(rapidjson::kParseErrorObjectMissCommaOrCurlyBracket));
+          return false;
+        }
         current_.remove_prefix(1);
       }
       ++count;
 
       // parse key
-      read_next_value(json_key);
-      index = process_key(json_key.value.string);
+      const span<const char> name = string_view();
+      if (failed())
+        return false;
+      index = find_key(map, slots, name);
       if (get_next_token() != ':')
-        MOT_THROW(error::rapidjson_e(rapidjson::kParseErrorObjectMissColon), nullptr);
+      {
+        fail(error::rapidjson_e(rapidjson::kParseErrorObjectMissColon));
+        return false;
+      }
       current_.remove_prefix(1);
 
       // parse value
@@ -393,17 +951,30 @@ namespace wire
     return true;
   }
 
-  [[noreturn]] void integer::throw_exception(std::intmax_t source, std::intmax_t min)
+  json_context::json_context()
+    : reader_(nullptr), temporary_()
   {
-    MOT_THROW(error::schema::larger_integer, (std::to_string(source) + " given when " + std::to_string(min) + " is minimum permitted").c_str());
+    if (thread_reader_used)
+    {
+      temporary_.reset(new json_reader{});
+      reader_ = temporary_.get();
+    }
+    else
+    {
+      thread_reader_used = true;
+      reader_ = std::addressof(thread_reader);
+    }
   }
-  [[noreturn]] void integer::throw_exception(std::uintmax_t source, std::uintmax_t max)
+
+  json_context::~json_context() noexcept
   {
-    MOT_THROW(error::schema::smaller_integer, (std::to_string(source) + " given when " + std::to_string(max) + "is maximum permitted").c_str());
+    reader_->reset(byte_rope{});
+    if (!temporary_)
+      thread_reader_used = false;
   }
 }
 
-[[noreturn]] void read_json::throw_exception(const wire::error::schema code, const char* display, span<char const* const> names)
+void read_json::missing_key(wire::json_reader& source, span<char const* const> names) noexcept
 {
   const char* name = nullptr;
   for (const char* elem : names)
@@ -414,5 +985,5 @@ namespace wire
       break;
     }
   }
-  MOT_THROW(code, (std::string{display} + (name ? name : "")).c_str());
+  source.fail(wire::error::schema::missing_key, name);
 }
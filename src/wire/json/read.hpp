@@ -29,12 +29,16 @@
 #ifndef WIRE_JSON_READ_HPP
 #define WIRE_JSON_READ_HPP
 
+#include <algorithm>
 #include <cstdint>
+#include <memory>
 #include <rapidjson/reader.h>
 #include <string>
 #include <type_traits>
+#include <vector>
 
-#include "byte_slice.hpp"
+#include "byte_rope.hpp"
+#include "expect.hpp"
 #include "span.hpp"
 #include "wire/error.hpp"
 #include "wire/field.hpp"
@@ -43,80 +47,233 @@
 
 namespace wire
 {
-  //! Reads JSON tokens one-at-a-time for DOMless parsing
+  /*! Reads JSON tokens one-at-a-time for DOMless parsing. Errors do not
+      throw; the first is recorded (see `fail`) and every later read returns
+      a default value without consuming input, so a malformed message
+      unwinds through normal returns. */
   class json_reader
   {
     struct rapidjson_sax;
 
-    byte_slice source_;
+    byte_rope source_;
     span<const std::uint8_t> current_;
-    std::string temp_str_;
+    std::vector<std::uint8_t> joined_; //!< Copy of token(s) split across segments
+    std::string temp_str_; //!< Unescaped strings; re-used
+    std::size_t next_segment_; //!< Index of next segment in `source_`
+    std::size_t pending_; //!< Bytes of `next_segment_` already copied to `joined_`
     std::size_t depth_; //!< Tracks number of recursive objects and arrays
+    std::error_code error_;
+    const char* error_detail_;
     rapidjson::Reader reader_;
 
-    //! \throw std::system_error if max depth is reached
-    void increment_depth();
+    //! \return True if bytes remain in segments after `current_`.
+    bool has_more() const noexcept { return next_segment_ < source_.segments(); }
+
+    //! Move to next segment. \pre `current_.empty() && has_more()`.
+    void next_segment() noexcept;
+
+    /*! Copy `current_` and some bytes from next segment into `joined_`. Only
+        used when a token straddles a segment boundary, which is rare.
+        \pre `has_more()`. */
+    void join_segments();
+
+    //! Fails if max depth is reached
+    void increment_depth() noexcept;
     void decrement_depth() noexcept { --depth_; }
 
-    void read_next_value(rapidjson_sax&);
-    char get_next_token();
-    span<const char> get_next_string();
+    //! Parse a number with rapidjson. \return False if parsing failed, and `handler` is unset.
+    bool read_next_value(rapidjson_sax& handler);
+    char get_next_token() noexcept;
+
+    //! \return Number token at start of `current_`, joining segments if split.
+    span<const std::uint8_t> get_next_number();
+
+  public:
+    //! Integer part of a number token.
+    struct number
+    {
+      std::uintmax_t magnitude;
+      bool negative;
+      bool fraction; //!< Has fraction or exponent
+      bool overflow; //!< `magnitude` is too large
+    };
+
+  private:
+    //! Fails if next number token is invalid. \return False on failure.
+    bool read_number(number& out);
+
+    //! Fails if next token not an integer (without fraction or overflow). \return False on failure.
+    bool read_integer(number& out);
+
+    //! Fails if `current_` does not start with `text`. \return False on failure.
+    bool literal(span<const char> text);
+
+    //! Fail with the error rapidjson gives when `next` starts a token that is not `expected`.
+    void wrong_type(char next, error::schema expected) noexcept;
 
-    //! Skips next value. \throw wire::read_error if invalid JSON syntax.
+    //! Unescape JSON string `source` into `temp_str_`. \return False on failure.
+    bool unescape(span<const std::uint8_t> source);
+
+    //! Read 4 hex digits after `source[i]`, and move `i` to the last. \return False on failure.
+    bool read_escaped_code(span<const std::uint8_t> source, std::size_t& i, std::uint32_t& code);
+
+    /*! Skips next value. Objects, arrays and strings are only checked for
+        matching quotes and brackets (see `skip_json`). */
     void skip_value();
 
   public:
     struct key_map
     {
       const char* name;
+      std::size_t length;
+      std::uint32_t hash; //!< `wire::key_hash(name, length)`
     };
-    explicit json_reader(byte_slice source);
+
+    //! \return Size of slot table for `count` keys: power of 2, at most half full.
+    static constexpr std::size_t key_slots(const std::size_t count, const std::size_t size = 2) noexcept
+    {
+      return count * 2 <= size ? size : key_slots(count, size * 2);
+    }
+
+    /*! Fill open-addressed `slots` (zeroed, `key_slots(hashes.size())`
+        entries) with `index + 1` of each entry in `hashes`, for use with
+        `key`. */
+    static void index_keys(span<const std::uint32_t> hashes, span<std::uint8_t> slots) noexcept;
+
+    /*! Small maps (4 fields or fewer) are scanned by length then name, and
+        larger maps are searched by hash and slot probe.
+        \param slots Filled by `index_keys` from the hashes in `map`.
+        \return Index of `name` in `map`, or `map.size()` if not found. */
+    static std::size_t find_key(span<const key_map> map, span<const std::uint8_t> slots, span<const char> name) noexcept;
+
+    //! Construct reader with no input; use `reset` before reading.
+    json_reader();
+    explicit json_reader(byte_rope source);
 
     json_reader(const json_reader&) = delete;
     json_reader& operator=(const json_reader&) = delete;
 
+    /*! Start reading `source` from the beginning, clearing any error. The
+        rapidjson stack and scratch buffers keep their capacity, so a reused
+        reader does not allocate once warm. */
+    void reset(byte_rope source) noexcept;
+
     //! \return Number of recursive objects and arrays
     std::size_t depth() const noexcept { return depth_; }
 
-    //! \throw std::system_error if JSON parsing is incomplete.
-    void check_complete() const;
+    //! \return True if an error was recorded. All reads are no-ops afterwards.
+    bool failed() const noexcept { return bool(error_); }
+
+    //! \return First recorded error.
+    std::error_code error() const noexcept { return error_; }
+
+    //! \return Key name related to `error()`, or `nullptr`.
+    const char* error_detail() const noexcept { return error_detail_; }
+
+    /*! Record `code` (and static string `detail`) unless an error was already
+        recorded, then drop all remaining input. */
+    void fail(std::error_code code, const char* detail = nullptr) noexcept;
 
-    //! \throw std:system_error if next token not a boolean.
+    //! \return `*value`, or `T{}` after recording `value.error()`.
+    template<typename T>
+    T check(expect<T> value) noexcept
+    {
+      if (!value)
+      {
+        fail(value.error());
+        return T{};
+      }
+      return std::move(*value);
+    }
+
+    //! \throw std::system_error with `error()` and `error_detail()` if `failed()`.
+    void throw_if_failed() const;
+
+    //! Fails if JSON parsing is incomplete.
+    void check_complete() noexcept;
+
+    //! Fails if next token not a boolean.
     bool boolean();
-    //! \throw std::system_error if next token not an integer.
+    //! Fails if next token not an integer.
     std::intmax_t integer();
-    //! \throw std::system_error if next token not an unsigned integer.
+    //! Fails if next token not an unsigned integer.
     std::uintmax_t unsigned_integer();
-    //! \throw std::system_error if next token is not a number
+    //! Fails if next token is not a number
     double real();
 
-    //! \throw std::system error if next token not a string. \return Next string token.
+    //! Fails if next token not a string. \return Next string token.
     std::string string();
-    //! \throw std::system_error if next token cannot be read as hex into `dest`.
+
+    /*! Fails if next token not a string. Control characters are not
+        rejected.
+      \return Next string token, pointing into the source when it has no
+          escapes, otherwise into a re-used buffer. Valid until the next read
+          from `this`. */
+    span<const char> string_view();
+
+    /*! Same as `string_view`, but shares the reference count of the source
+        buffer instead of copying when possible.
+      \return Next string token. */
+    byte_slice string_slice();
+    //! Fails if next token cannot be read as hex into `dest`.
     void binary(span<std::uint8_t> dest);
-    //! \throw std::system_error if next token is not a string in `enums`. \return Index with `enums` of match.
+    //! Fails if next token is not a string in `enums`. \return Index with `enums` of match, or `enums.size()`.
     std::size_t enumeration(span<char const* const> enums);
 
 
-    //! \throw std::system_error if next token not `[`.
+    //! Fails if next token not `[`.
     void start_array();
 
-    //! Skips whitespace to next token. \return True if next token is eof or ']'.
+    /*! Skips whitespace to next token. Fails if not `,` or `]`.
+      \return True if next token is ']' or reader failed. */
     bool is_array_end(std::size_t count);
 
-    //! \throw std::system_error if next token not `]`.
+    /*! \return Bytes not yet read in the current segment. Used to estimate
+        array sizes without scanning ahead. */
+    std::size_t segment_remaining() const noexcept { return current_.size(); }
+
     void end_array() noexcept { decrement_depth(); }
 
 
-    //! \throw std::system_error if next token not `{`.
+    //! Fails if next token not `{`.
     void start_object();
 
-    /*! \throw std::system_error if next token not `,` or `}`.
+    /*! Fails if next token not `,` or `}`.
+      \param slots Filled by `index_keys(map, slots)`.
       \return True if another value to read. */
-    bool key(span<const key_map> map, std::size_t count, std::size_t& next);
+    bool key(span<const key_map> map, span<const std::uint8_t> slots, std::size_t count, std::size_t& next);
+
+    /*! Speculative alternative to `key`, for daemon output with a fixed
+        key order. Nothing is consumed unless the next key is exactly
+        `name`, in which case the key and `:` are consumed.
+      \param count Number of keys already read in this object.
+      \return True if next key is `name`. */
+    bool ordered_key(const char* name, std::size_t length, std::size_t count);
+
+    //! Skips whitespace to next token. \return True if it was `}` (and consume it).
+    bool is_object_end();
 
     void end_object() noexcept { decrement_depth(); }
   };
+
+  /*! Borrows the `json_reader` kept by the calling thread, so decode
+      buffers stay warm across messages. A nested borrow on the same thread
+      gets a temporary reader instead. The input is released when `this` is
+      destroyed. */
+  class json_context
+  {
+    json_reader* reader_;
+    std::unique_ptr<json_reader> temporary_;
+
+  public:
+    json_context();
+    ~json_context() noexcept;
+
+    json_context(const json_context&) = delete;
+    json_context& operator=(const json_context&) = delete;
+
+    json_reader& operator*() const noexcept { return *reader_; }
+  };
 } // wire
 
 namespace read_json
@@ -127,38 +284,123 @@ namespace read_json
       `read_bytes` in this namespace to "find" user functions that are declared
       after these functions. */
 
-  [[noreturn]] void throw_exception(const wire::error::schema code, const char* display, span<char const* const> names);
+  //! Fail `source` with `missing_key`, detailed by first non-null entry in `names`.
+  void missing_key(wire::json_reader& source, span<char const* const> names) noexcept;
+
+  /*! Decode `source` into `dest` using `reader`. Buffers already in `dest`
+      are re-used where possible. `source` is released before returning.
+      \return Error if conversion from `source` to `T` fails; `dest` is then
+          partially written. */
+  template<typename T>
+  inline expect<void> try_to(wire::json_reader& reader, byte_rope source, T& dest)
+  {
+    reader.reset(std::move(source));
+    read_bytes(reader, dest);
+    reader.check_complete();
+
+    const std::error_code error = reader.error();
+    reader.reset(byte_rope{});
+    if (error)
+      return error;
+    return success();
+  }
+
+  //! \return Error if conversion from `source` to `T` fails.
+  template<typename T>
+  inline expect<T> try_to(byte_rope source)
+  {
+    T dest{};
+    const wire::json_context reader{};
+    MOT_CHECK(try_to(*reader, std::move(source), dest));
+    return {std::move(dest)};
+  }
 
   //! \throw std::system_error if conversion from `source` to `T` fails.
   template<typename T>
-  inline T to(byte_slice source)
+  inline T to(byte_rope source)
   {
     T dest{};
     {
-      wire::json_reader reader{std::move(source)};
-      read_bytes(reader, dest);
-      reader.check_complete();
+      const wire::json_context reader{};
+      (*reader).reset(std::move(source));
+      read_bytes(*reader, dest);
+      (*reader).check_complete();
+      (*reader).throw_if_failed();
     }
     return dest;
   }
 
 
+  //! Call `visit(source)` for each element of an array as it is parsed; nothing is stored.
+  template<typename F>
+  inline void visit_array(wire::json_reader& source, F& visit)
+  {
+    source.start_array();
+    for (std::size_t count = 0; !source.is_array_end(count); ++count)
+      visit(source);
+    source.end_array();
+  }
+
+  //! Most elements `array` reserves from its size estimate.
+  constexpr const std::size_t max_array_reserve = 64;
+
   template<typename T>
   inline void array(wire::json_reader& source, T& dest)
   {
     source.start_array();
 
-    dest.clear();
-    for (std::size_t count = 0; !source.is_array_end(count); ++count)
+    // re-use existing elements (and their buffers); every field is required, so each is overwritten
+    std::size_t count = 0;
+    for ( ; !source.is_array_end(count); ++count)
     {
-      dest.emplace_back();
-      read_bytes(source, dest.back());
+      if (count == dest.size())
+        dest.emplace_back();
+
+      const std::size_t remaining = source.segment_remaining();
+      read_bytes(source, dest[count]);
+
+      /* estimate size from width of first element and bytes left, instead
+         of a second pass. Bytes left include the rest of the message, not
+         just this array, so cap the estimate; growth handles larger arrays. */
+      const std::size_t after = source.segment_remaining();
+      if (count == 0 && after < remaining)
+      {
+        const std::size_t estimate = 1 + after / (remaining - after + 1); // `,` between values
+        const std::size_t values = std::min(estimate, max_array_reserve);
+        if (dest.capacity() < values)
+          dest.reserve(values);
+      }
     }
+    dest.erase(dest.begin() + count, dest.end());
 
     return source.end_array();
   }
 
 
+  /*! Slot table for `json_reader::key`. Depends only on the field hashes,
+      so it is built once per `Hash` pack instead of once per object. */
+  template<std::uint32_t... Hash>
+  class key_table
+  {
+    static constexpr const std::size_t size = wire::json_reader::key_slots(sizeof...(Hash));
+    std::uint8_t slots_[size];
+
+    key_table() noexcept
+      : slots_()
+    {
+      const std::uint32_t hashes[sizeof...(Hash) + 1] = {Hash..., 0};
+      wire::json_reader::index_keys({hashes, sizeof...(Hash)}, slots_);
+    }
+
+  public:
+    //! \return Table for `Hash` in declaration order.
+    static span<const std::uint8_t> get()
+    {
+      static const key_table table{};
+      return table.slots_;
+    }
+  };
+
   //! Tracks read status of every object field instance.
   template<typename T>
   class tracker
@@ -181,23 +423,38 @@ namespace read_json
       return (is_required() && !read_) ? field_.name : nullptr;
     }
 
+    //! Read next value if the next key is this field. \return True if read.
+    bool try_read_ordered(wire::json_reader& source, const std::size_t count)
+    {
+      if (!source.ordered_key(field_.name, field_.name_length, count))
+        return false;
+      read_bytes(source, field_.get_value());
+      read_ = true;
+      return true;
+    }
+
     //! Set all entries in `map` related to this field (expand variant types!).
     template<std::size_t N>
     std::size_t set_mapping(std::size_t index, wire::json_reader::key_map (&map)[N])
     {
       our_index_ = index;
       map[index].name = field_.name;
+      map[index].length = field_.name_length;
+      map[index].hash = field_.name_hash;
       return index + count();
     }
 
-    //! Try to read next value if `index` matches `this`. \return 0 if no match, 1 if optional field read, and 2 if required field read
+    //! Try to read next value if `index` matches `this`. \return 0 if no match, 1 if optional field read (or duplicate), and 2 if required field read
     template<typename R>
     std::size_t try_read(R& source, const std::size_t index)
     {
       if (our_index_ != index)
         return 0;
       if (read_)
-        throw_exception(wire::error::schema::invalid_key, "duplicate", {std::addressof(field_.name), 1});
+      {
+        source.fail(wire::error::schema::invalid_key, field_.name); // duplicate
+        return 1;
+      }
 
       read_bytes(source, field_.get_value());
       read_ = true;
@@ -219,26 +476,44 @@ namespace read_json
     expand_tracker_map(head.set_mapping(index, map), map, tail...);
   }
 
+  // `read_ordered` reads fields while keys arrive in declaration order
+
+  inline constexpr std::size_t read_ordered(wire::json_reader&, const std::size_t count)
+  {
+    return count;
+  }
+
+  template<typename T, typename... U>
+  inline std::size_t read_ordered(wire::json_reader& source, const std::size_t count, tracker<T>& head, tracker<U>&... tail)
+  {
+    return head.try_read_ordered(source, count) ?
+      read_ordered(source, count + 1, tail...) : count;
+  }
+
+  //! Read remaining keys of an object, after `count` keys were read. \pre `start_object()` called.
   template<typename... T>
-  inline void object(wire::json_reader& source, tracker<T>... fields)
+  inline void read_object(wire::json_reader& source, const std::size_t start, tracker<T>&... fields)
   {
-    static constexpr const std::size_t total_subfields = wire::sum(fields.count()...);
-    static_assert(total_subfields < 100, "algorithm uses too much stack space and linear searching");
+    static constexpr const std::size_t total_subfields = wire::sum(tracker<T>::count()...);
+    static_assert(total_subfields < 100, "algorithm uses too much stack space");
+    static_assert(total_subfields == sizeof...(T), "key_table has one hash per field");
 
-    source.start_object();
-    std::size_t required = wire::sum(std::size_t(fields.is_required())...);
+    std::size_t required = wire::sum(std::size_t(fields.name_if_missing() != nullptr)...);
 
-    wire::json_reader::key_map map[total_subfields] = {};
+    // every entry is written; names are from the caller, so not cached with `slots`
+    wire::json_reader::key_map map[total_subfields];
     expand_tracker_map(0, map, fields...);
 
+    const span<const std::uint8_t> slots = key_table<T::name_hash...>::get();
+
     std::size_t next = 0;
-    for (std::size_t count = 0; source.key(map, count, next); ++count)
+    for (std::size_t count = start; source.key(map, slots, count, next); ++count)
     {
       switch (wire::sum(fields.try_read(source, next)...))
       {
       default:
       case 0:
-        throw_exception(wire::error::schema::invalid_key, "bad map setup", nullptr);
+        source.fail(wire::error::schema::invalid_key, "bad map setup");
         break;
       case 2:
         --required; /* fallthrough */
@@ -247,14 +522,35 @@ namespace read_json
       }
     }
 
-    if (required)
+    if (required && !source.failed())
     {
       const char* missing[] = {fields.name_if_missing()...};
-      throw_exception(wire::error::schema::missing_key, "", missing);
+      missing_key(source, missing);
     }
 
     source.end_object();
   }
+
+  template<typename... T>
+  inline void object(wire::json_reader& source, tracker<T>... fields)
+  {
+    source.start_object();
+    read_object(source, 0, fields...);
+  }
+
+  /*! Same result as `object`, but first assumes keys arrive in declaration
+      order, checking each with one `memcmp`. The first unexpected key (or
+      any key after the last field) switches to `read_object`, which still
+      detects duplicate and missing keys. */
+  template<typename... T>
+  inline void ordered_object(wire::json_reader& source, tracker<T>... fields)
+  {
+    source.start_object();
+    const std::size_t count = read_ordered(source, 0, fields...);
+    if (count == sizeof...(T) && source.is_object_end())
+      return source.end_object();
+    read_object(source, count, fields...);
+  }
 } // read_json
 
 namespace wire
@@ -263,11 +559,8 @@ namespace wire
 
   namespace integer
   {
-    [[noreturn]] void throw_exception(std::intmax_t source, std::intmax_t min);
-    [[noreturn]] void throw_exception(std::uintmax_t source, std::uintmax_t max);
-
     template<typename Target, typename U>
-    inline Target convert_to(const U source)
+    inline expect<Target> convert_to(const U source) noexcept
     {
       using common = typename std::common_type<Target, U>::type;
       static constexpr const Target target_min = std::numeric_limits<Target>::min();
@@ -279,42 +572,84 @@ namespace wire
            * 2 checks for signed -> unsigned-- (
            * 1 check for unsigned -> signed (uint, uint)
 
-         Put `WIRE_DLOG_THROW` in cpp to reduce code/ASM duplication. Do not
-         remove first check, signed values can be implicitly converted to
-         unsigned in some checks. */
+         Do not remove first check, signed values can be implicitly
+         converted to unsigned in some checks. */
       if (!std::numeric_limits<Target>::is_signed && source < 0)
-        throw_exception(std::intmax_t(source), std::intmax_t(0));
-      else if (common(source) < common(target_min))
-        throw_exception(std::intmax_t(source), std::intmax_t(target_min));
+        return {error::schema::larger_integer};
+      else if (std::numeric_limits<U>::is_signed && common(source) < common(target_min))
+        return {error::schema::larger_integer};
       else if (common(target_max) < common(source))
-        throw_exception(std::uintmax_t(source), std::uintmax_t(target_max));
+        return {error::schema::smaller_integer};
 
       return Target(source);
     }
   }
 
   template<typename T>
-  inline T json::from_bytes(byte_slice source)
+  inline T json::from_bytes(byte_rope source)
   {
     return read_json::to<T>(std::move(source));
   }
 
+  template<typename T>
+  inline expect<T> json::try_from_bytes(byte_rope source)
+  {
+    return read_json::try_to<T>(std::move(source));
+  }
+
+  template<typename T>
+  inline expect<void> json::try_from_bytes(byte_rope source, T& dest, json_reader& context)
+  {
+    return read_json::try_to(context, std::move(source), dest);
+  }
+
 
   inline void read_bytes(json_reader& source, bool& dest)
   {
     dest = source.boolean();
   }
+  inline void read_bytes(json_reader& source, int& dest)
+  {
+    dest = source.check(integer::convert_to<int>(source.integer()));
+  }
   inline void read_bytes(json_reader& source, unsigned& dest)
   {
-    dest = integer::convert_to<unsigned>(source.unsigned_integer());
+    dest = source.check(integer::convert_to<unsigned>(source.unsigned_integer()));
   }
   inline void read_bytes(json_reader& source, unsigned long& dest)
   {
-    dest = integer::convert_to<unsigned long>(source.unsigned_integer());
+    dest = source.check(integer::convert_to<unsigned long>(source.unsigned_integer()));
   }
   inline void read_bytes(json_reader& source, unsigned long long& dest)
   {
-    dest = integer::convert_to<unsigned long long>(source.unsigned_integer());
+    dest = source.check(integer::convert_to<unsigned long long>(source.unsigned_integer()));
+  }
+
+  //! Keeps a reference to the source buffer, instead of a copy, when possible.
+  inline void read_bytes(json_reader& source, byte_slice& dest)
+  {
+    dest = source.string_slice();
+  }
+
+  //! Field value that streams a JSON array through `visit`, see `visit_each`.
+  template<typename F>
+  struct array_visitor
+  {
+    F visit;
+  };
+
+  /*! \return Field value that calls `visit(json_reader&)` once per array
+      element, while parsing, instead of storing the array. */
+  template<typename F>
+  inline array_visitor<F> visit_each(F visit)
+  {
+    return {std::move(visit)};
+  }
+
+  template<typename F>
+  inline void read_bytes(json_reader& source, array_visitor<F>& dest)
+  {
+    read_json::visit_array(source, dest.visit);
   }
 
   template<typename T>
@@ -329,10 +664,17 @@ namespace wire
     source.binary(as_mut_byte_span(dest));
   }
 
-  template<typename... T>
-  inline void object(json_reader& source, field_<T>... fields)
+  template<typename... T, std::uint32_t... H>
+  inline void object(json_reader& source, field_<T, H>... fields)
+  {
+    read_json::object(source, read_json::tracker<field_<T, H>>{std::move(fields)}...);
+  }
+
+  //! Use for daemon output with a fixed key order, see `read_json::ordered_object`.
+  template<typename... T, std::uint32_t... H>
+  inline void ordered_object(json_reader& source, field_<T, H>... fields)
   {
-    read_json::object(source, read_json::tracker<field_<T>>{std::move(fields)}...);
+    read_json::ordered_object(source, read_json::tracker<field_<T, H>>{std::move(fields)}...);
   }
 } // wire
 
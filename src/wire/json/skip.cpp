@@ -0,0 +1,232 @@
+// Copyright (c) 2020, Lee Clagett
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "wire/json/skip.hpp"
+
+#include "wire/error.hpp"
+#include "wire/json/error.hpp"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+  #define MOTRIX_SKIP_X86 1
+  #include <immintrin.h>
+#endif
+
+namespace
+{
+  //! \return False if nesting is too deep.
+  bool push(wire::skip_state& state, const bool object) noexcept
+  {
+    if (state.depth == wire::max_skip_depth)
+    {
+      state.error = wire::error::schema::maximum_depth;
+      return false;
+    }
+
+    std::uint64_t& word = state.objects[state.depth / 64];
+    const std::uint64_t bit = std::uint64_t(1) << (state.depth % 64);
+    word = object ? (word | bit) : (word & ~bit);
+    ++state.depth;
+    return true;
+  }
+
+  //! \return False if closing bracket does not match.
+  bool pop(wire::skip_state& state, const bool object) noexcept
+  {
+    if (!state.depth)
+    {
+      state.error = wire::error::rapidjson_e(rapidjson::kParseErrorDocumentRootNotSingular);
+      return false;
+    }
+
+    --state.depth;
+    const bool is_object = (state.objects[state.depth / 64] >> (state.depth % 64)) & 1;
+    if (is_object != object)
+    {
+      state.error = wire::error::rapidjson_e(
+        is_object ?
+          rapidjson::kParseErrorObjectMissCommaOrCurlyBracket : rapidjson::kParseErrorArrayMissCommaOrSquareBracket
+      );
+      return false;
+    }
+    return true;
+  }
+
+  /*! Process a quote or bracket (backslashes are handled by caller).
+      \return True if scanning stops after `c`; the value ended (`done` is
+          set) or brackets are invalid (`error` is set). */
+  inline bool step(wire::skip_state& state, const std::uint8_t c) noexcept
+  {
+    if (state.in_string)
+    {
+      if (c != '"')
+        return false;
+      state.in_string = false;
+      return state.done = (state.depth == 0);
+    }
+
+    switch (c)
+    {
+    case '"':
+      state.in_string = true;
+      break;
+    case '{':
+    case '[':
+      return !push(state, c == '{');
+    case '}':
+    case ']':
+      if (!pop(state, c == '}'))
+        return true;
+      return state.done = (state.depth == 0);
+    default:
+      break;
+    }
+    return false;
+  }
+
+  //! Byte-at-a-time scan from `i`. \return Bytes consumed.
+  std::size_t skip_scalar(wire::skip_state& state, const std::uint8_t* data, std::size_t i, const std::size_t size)
+  {
+    for (; i < size; ++i)
+    {
+      const std::uint8_t c = data[i];
+      if (state.escaped)
+        state.escaped = false;
+      else if (state.in_string && c == '\\')
+        state.escaped = true;
+      else if (step(state, c))
+        return i + 1;
+    }
+    return size;
+  }
+
+  std::size_t skip_scalar(wire::skip_state& state, const std::uint8_t* data, const std::size_t size)
+  {
+    return skip_scalar(state, data, 0, size);
+  }
+
+#ifdef MOTRIX_SKIP_X86
+  /* `Mask` returns a bit for every quote, backslash and bracket in a block.
+     Blocks without any are skipped in one step; the remaining bits go
+     through `step`. Forced inline so the `Mask` intrinsics are compiled for
+     the `target` of the caller. */
+  template<std::size_t Block, std::uint32_t (*Mask)(const std::uint8_t*)>
+  inline __attribute__((always_inline))
+  std::size_t skip_blocks(wire::skip_state& state, const std::uint8_t* data, const std::size_t size)
+  {
+    std::size_t i = 0;
+    for (; Block <= size - i; i += Block)
+    {
+      std::uint32_t mask = Mask(data + i);
+      if (state.escaped)
+      {
+        state.escaped = false;
+        mask &= ~std::uint32_t(1);
+      }
+
+      while (mask)
+      {
+        const unsigned bit = __builtin_ctz(mask);
+        mask &= mask - 1;
+
+        const std::uint8_t c = data[i + bit];
+        if (state.in_string && c == '\\')
+        {
+          if (bit + 1 < Block)
+            mask &= ~(std::uint32_t(1) << (bit + 1)); // escaped character
+          else
+            state.escaped = true;
+        }
+        else if (step(state, c))
+          return i + bit + 1;
+      }
+    }
+    return skip_scalar(state, data, i, size);
+  }
+
+  __attribute__((target("sse2")))
+  inline std::uint32_t structural_mask_sse2(const std::uint8_t* block) noexcept
+  {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+
+    // '[' and ']' are '{' and '}' with bit 5 cleared
+    const __m128i brackets = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+    const __m128i found = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('"')), _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\\'))),
+      _mm_or_si128(_mm_cmpeq_epi8(brackets, _mm_set1_epi8('{')), _mm_cmpeq_epi8(brackets, _mm_set1_epi8('}')))
+    );
+    return std::uint32_t(_mm_movemask_epi8(found));
+  }
+
+  __attribute__((target("avx2")))
+  inline std::uint32_t structural_mask_avx2(const std::uint8_t* block) noexcept
+  {
+    const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    const __m256i brackets = _mm256_or_si256(bytes, _mm256_set1_epi8(0x20));
+    const __m256i found = _mm256_or_si256(
+      _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\\'))),
+      _mm256_or_si256(_mm256_cmpeq_epi8(brackets, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(brackets, _mm256_set1_epi8('}')))
+    );
+    return std::uint32_t(_mm256_movemask_epi8(found));
+  }
+
+  __attribute__((target("sse2")))
+  std::size_t skip_sse2(wire::skip_state& state, const std::uint8_t* data, const std::size_t size)
+  {
+    return skip_blocks<16, structural_mask_sse2>(state, data, size);
+  }
+
+  __attribute__((target("avx2")))
+  std::size_t skip_avx2(wire::skip_state& state, const std::uint8_t* data, const std::size_t size)
+  {
+    return skip_blocks<32, structural_mask_avx2>(state, data, size);
+  }
+#endif // MOTRIX_SKIP_X86
+
+  using skip_function = std::size_t (*)(wire::skip_state&, const std::uint8_t*, std::size_t);
+
+  skip_function select_skip() noexcept
+  {
+#ifdef MOTRIX_SKIP_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+      return skip_avx2;
+    if (__builtin_cpu_supports("sse2"))
+      return skip_sse2;
+#endif
+    return skip_scalar;
+  }
+}
+
+namespace wire
+{
+  std::size_t skip_json(skip_state& state, const span<const std::uint8_t> source)
+  {
+    static const skip_function skip = select_skip();
+    return skip(state, source.data(), source.size());
+  }
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2020, Lee Clagett
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOTRIX_WIRE_JSON_SKIP_HPP
+#define MOTRIX_WIRE_JSON_SKIP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <system_error>
+
+#include "span.hpp"
+
+namespace wire
+{
+  //! Progress of `skip_json`, carried across rope segments. Zero-initialize before the first call.
+  struct skip_state
+  {
+    std::error_code error;    //!< Set on mismatched brackets or too much nesting
+    std::uint64_t objects[2]; //!< Bit `i` is set if nesting level `i` is an object
+    std::uint32_t depth;
+    bool in_string;
+    bool escaped; //!< Next byte follows a backslash in a string
+    bool done;    //!< Value ended
+  };
+
+  //! Maximum nesting supported by `skip_json`.
+  constexpr const std::size_t max_skip_depth = 128;
+
+  /*! Find the end of the JSON object, array or string that begins at
+      `source[0]` (with zero-initialized `state`), or continue a previous
+      scan. Input is read 16 or 32 bytes at a time (SSE2/AVX2 when
+      available), and only quotes, escapes and brackets are examined - the
+      skipped contents are not validated.
+
+      \return Bytes of `source` belonging to the value. `state.done` is set
+          if the value ended within those bytes. On mismatched brackets, or
+          nesting beyond `max_skip_depth`, `state.error` is set and scanning
+          stops. */
+  std::size_t skip_json(skip_state& state, span<const std::uint8_t> source);
+}
+
+#endif // MOTRIX_WIRE_JSON_SKIP_HPP
@@ -102,8 +102,8 @@ namespace write_json
     dest.end_array();
   }
 
-  template<typename T>
-  inline bool field(wire::json_writer& dest, const wire::field_<T> elem)
+  template<typename T, std::uint32_t H>
+  inline bool field(wire::json_writer& dest, const wire::field_<T, H> elem)
   {
     dest.key(elem.name);
     write_bytes(dest, elem.get_value());
@@ -129,6 +129,10 @@ namespace wire
     dest.unsigned_integer(source);
   }
   void write_bytes(json_writer& dest, const char* source);
+  inline void write_bytes(json_writer& dest, const byte_slice& source)
+  {
+    dest.string({reinterpret_cast<const char*>(source.data()), source.size()});
+  }
 
   template<typename T>
   inline typename std::enable_if<is_blob<T>::value>::type write_bytes(json_writer& dest, const T& source)
@@ -144,13 +148,20 @@ namespace wire
   }
 
 
-  template<typename... T>
-  inline void object(json_writer& dest, const field_<T>... fields)
+  template<typename... T, std::uint32_t... H>
+  inline void object(json_writer& dest, const field_<T, H>... fields)
   {
     dest.start_object();
     const bool dummy[] = {write_json::field(dest, fields)...};
     dest.end_object();
   }
+
+  //! Fields are always written in declaration order; allows shared read/write maps.
+  template<typename... T, std::uint32_t... H>
+  inline void ordered_object(json_writer& dest, const field_<T, H>... fields)
+  {
+    object(dest, fields...);
+  }
 }
 
 #endif // WIRE_JSON_WRITE_HPP
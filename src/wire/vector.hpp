@@ -36,8 +36,8 @@
 
 namespace wire
 {
-  template<typename T>
-  struct is_array<std::vector<T>> :
+  template<typename T, typename A>
+  struct is_array<std::vector<T, A>> :
     std::true_type
   {};
 }
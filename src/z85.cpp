@@ -0,0 +1,198 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "z85.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+  #define MOTRIX_Z85_X86 1
+  #include <immintrin.h>
+#endif
+
+namespace
+{
+  constexpr const char alphabet[] =
+    "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ.-:+=^!/*?&<>()[]{}@%$#";
+  static_assert(sizeof(alphabet) == 86, "bad z85 alphabet");
+
+  constexpr const std::size_t words = sizeof(monero::hash) / 4;
+  constexpr const std::size_t digits = 5; //!< Characters per 4 byte word
+
+  /* `value / 85` is `(value * magic) >> 38` for every 32-bit `value`, so no
+     divide instruction is needed, and the SIMD kernels can use 32x32->64 bit
+     multiplies. */
+  constexpr const std::uint32_t div85_magic = 0xC0C0C0C1;
+  constexpr const unsigned div85_shift = 38;
+
+  inline std::uint32_t div85(const std::uint32_t value) noexcept
+  {
+    return std::uint32_t((std::uint64_t(value) * div85_magic) >> div85_shift);
+  }
+
+  //! Write characters for `remainders[digit][word]` of one hash to `out`.
+  void write_digits(to_z85::hash_text& out, const std::uint32_t (&remainders)[digits][words]) noexcept
+  {
+    for (std::size_t word = 0; word < words; ++word)
+    {
+      for (std::size_t digit = 0; digit < digits; ++digit)
+        out[word * digits + digit] = alphabet[remainders[digit][word]];
+    }
+    out[words * digits] = 0;
+  }
+
+  void encode_scalar(to_z85::hash_text* out, const monero::hash* src, const std::size_t count) noexcept
+  {
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      std::uint32_t remainders[digits][words];
+      for (std::size_t word = 0; word < words; ++word)
+      {
+        const std::uint8_t* bytes = src[i].data + word * 4;
+        std::uint32_t value =
+          (std::uint32_t(bytes[0]) << 24) | (std::uint32_t(bytes[1]) << 16) | (std::uint32_t(bytes[2]) << 8) | bytes[3];
+
+        for (std::size_t digit = digits; digit--; )
+        {
+          const std::uint32_t quotient = div85(value);
+          remainders[digit][word] = value - quotient * 85;
+          value = quotient;
+        }
+      }
+      write_digits(out[i], remainders);
+    }
+  }
+
+  using encode_function = void (*)(to_z85::hash_text*, const monero::hash*, std::size_t);
+
+#ifdef MOTRIX_Z85_X86
+  /* Each 32-bit lane holds one big-endian word of a hash; the 8 words of a
+     hash are divided by 85 together, five times. */
+
+  //! \return `value / 85` in each 32-bit lane.
+  __attribute__((target("sse2")))
+  inline __m128i div85(const __m128i value) noexcept
+  {
+    const __m128i magic = _mm_set1_epi32(int(div85_magic));
+    const __m128i even = _mm_srli_epi64(_mm_mul_epu32(value, magic), div85_shift);
+    const __m128i odd = _mm_srli_epi64(_mm_mul_epu32(_mm_srli_epi64(value, 32), magic), div85_shift);
+    return _mm_or_si128(even, _mm_slli_epi64(odd, 32));
+  }
+
+  __attribute__((target("avx2")))
+  inline __m256i div85(const __m256i value) noexcept
+  {
+    const __m256i magic = _mm256_set1_epi32(int(div85_magic));
+    const __m256i even = _mm256_srli_epi64(_mm256_mul_epu32(value, magic), div85_shift);
+    const __m256i odd = _mm256_srli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(value, 32), magic), div85_shift);
+    return _mm256_or_si256(even, _mm256_slli_epi64(odd, 32));
+  }
+
+  //! \return Big-endian 32-bit lanes of `bytes` (SSE2 has no byte shuffle).
+  __attribute__((target("sse2")))
+  inline __m128i load_big_endian(const std::uint8_t* bytes) noexcept
+  {
+    const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+    const __m128i middle = _mm_set1_epi32(0x0000FF00);
+    return _mm_or_si128(
+      _mm_or_si128(_mm_slli_epi32(value, 24), _mm_srli_epi32(value, 24)),
+      _mm_or_si128(_mm_slli_epi32(_mm_and_si128(value, middle), 8), _mm_and_si128(_mm_srli_epi32(value, 8), middle))
+    );
+  }
+
+  //! 4 words per step, 2 steps per hash.
+  __attribute__((target("sse2")))
+  void encode_sse2(to_z85::hash_text* out, const monero::hash* src, const std::size_t count) noexcept
+  {
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      alignas(16) std::uint32_t remainders[digits][words];
+      for (std::size_t half = 0; half < words; half += 4)
+      {
+        __m128i value = load_big_endian(src[i].data + half * 4);
+        for (std::size_t digit = digits; digit--; )
+        {
+          // 85 = 64 + 16 + 4 + 1, SSE2 has no 32-bit multiply low
+          const __m128i quotient = div85(value);
+          const __m128i product = _mm_add_epi32(
+            _mm_add_epi32(quotient, _mm_slli_epi32(quotient, 2)),
+            _mm_add_epi32(_mm_slli_epi32(quotient, 4), _mm_slli_epi32(quotient, 6))
+          );
+          _mm_store_si128(reinterpret_cast<__m128i*>(remainders[digit] + half), _mm_sub_epi32(value, product));
+          value = quotient;
+        }
+      }
+      write_digits(out[i], remainders);
+    }
+  }
+
+  //! One hash per step.
+  __attribute__((target("avx2")))
+  void encode_avx2(to_z85::hash_text* out, const monero::hash* src, const std::size_t count) noexcept
+  {
+    const __m256i swap = _mm256_setr_epi8(
+      3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+      3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12
+    );
+    const __m256i base = _mm256_set1_epi32(85);
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      alignas(32) std::uint32_t remainders[digits][words];
+      __m256i value = _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src[i].data)), swap);
+      for (std::size_t digit = digits; digit--; )
+      {
+        const __m256i quotient = div85(value);
+        const __m256i remainder = _mm256_sub_epi32(value, _mm256_mullo_epi32(quotient, base));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(remainders[digit]), remainder);
+        value = quotient;
+      }
+      write_digits(out[i], remainders);
+    }
+  }
+#endif // MOTRIX_Z85_X86
+
+  encode_function select_encode() noexcept
+  {
+#ifdef MOTRIX_Z85_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+      return encode_avx2;
+    if (__builtin_cpu_supports("sse2"))
+      return encode_sse2;
+#endif
+    return encode_scalar;
+  }
+}
+
+void to_z85::hashes(const span<hash_text> out, const span<const monero::hash> src) noexcept
+{
+  static const encode_function encode = select_encode();
+  encode(out.data(), src.data(), std::min(out.size(), src.size()));
+}
@@ -0,0 +1,109 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "z85_cache.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+z85_cache::z85_cache(const std::size_t capacity)
+  : entries_(capacity), missing_(), encoded_(capacity), hand_(0)
+{
+  if (!capacity)
+    throw std::invalid_argument{"z85_cache capacity must be non-zero"};
+  missing_.reserve(capacity);
+}
+
+z85_cache::entry* z85_cache::find(const monero::hash& id) noexcept
+{
+  for (entry& current : entries_)
+  {
+    if (current.used && current.id == id)
+      return std::addressof(current);
+  }
+  return nullptr;
+}
+
+z85_cache::entry& z85_cache::evict() noexcept
+{
+  // clock: evict the first entry not read since the hand last passed it
+  while (entries_[hand_].referenced)
+  {
+    entries_[hand_].referenced = false;
+    hand_ = (hand_ + 1) % entries_.size();
+  }
+
+  entry& replaced = entries_[hand_];
+  hand_ = (hand_ + 1) % entries_.size();
+  return replaced;
+}
+
+void z85_cache::prefill(span<const monero::hash> ids) noexcept
+{
+  missing_.clear();
+  for (const monero::hash& id : ids)
+  {
+    if (missing_.size() == capacity())
+      break;
+
+    entry* const cached = find(id);
+    if (cached)
+      cached->referenced = true;
+    else if (std::find(missing_.begin(), missing_.end(), id) == missing_.end())
+      missing_.push_back(id);
+  }
+
+  to_z85::hashes(to_mut_span(encoded_), to_span(missing_));
+  for (std::size_t i = 0; i < missing_.size(); ++i)
+  {
+    // referenced, so each survives the hand passing once before it is read
+    entry& replaced = evict();
+    replaced.id = missing_[i];
+    replaced.encoded = encoded_[i];
+    replaced.used = true;
+    replaced.referenced = true;
+  }
+}
+
+const z85_cache::text& z85_cache::get(const monero::hash& id) noexcept
+{
+  entry* const cached = find(id);
+  if (cached)
+  {
+    cached->referenced = true;
+    return cached->encoded;
+  }
+
+  entry& replaced = evict();
+  replaced.id = id;
+  replaced.encoded = to_z85::hash(id);
+  replaced.used = true;
+  replaced.referenced = true;
+  return replaced.encoded;
+}
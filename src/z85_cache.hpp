@@ -0,0 +1,96 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef MOTRIX_Z85_CACHE_HPP
+#define MOTRIX_Z85_CACHE_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "monero_data.hpp"
+#include "span.hpp"
+#include "z85.hpp"
+
+/*! \brief Bounded cache of z85 text for hashes being displayed.
+
+    Sized to what the screen can show instead of the number of hashes, so
+    memory does not grow with the txpool. Entries are replaced with the
+    clock algorithm (an approximation of LRU); a lookup is a linear scan,
+    which is cheap at screen-sized capacities. Text for upcoming hashes can
+    be encoded in one batch with `prefill`. Nothing allocates after
+    construction. */
+class z85_cache
+{
+public:
+  using text = to_z85::hash_text;
+
+private:
+  struct entry
+  {
+    monero::hash id;
+    text encoded;
+    bool used;
+    bool referenced; //!< Read since the clock hand last passed
+  };
+
+  std::vector<entry> entries_;
+  std::vector<monero::hash> missing_; //!< `prefill` scratch
+  std::vector<text> encoded_;         //!< `prefill` scratch
+  std::size_t hand_;
+
+  //! \return Cached entry for `id`, or `nullptr`.
+  entry* find(const monero::hash& id) noexcept;
+
+  //! \return Entry to replace with new text; the clock hand moves past it.
+  entry& evict() noexcept;
+
+public:
+  //! \throw std::invalid_argument if `capacity == 0`.
+  explicit z85_cache(std::size_t capacity);
+
+  z85_cache(const z85_cache&) = delete;
+  z85_cache& operator=(const z85_cache&) = delete;
+
+  std::size_t capacity() const noexcept { return entries_.size(); }
+
+  //! \return Bytes allocated by `this`, for memory accounting.
+  std::size_t memory_usage() const noexcept
+  {
+    return entries_.capacity() * sizeof(entry) +
+      missing_.capacity() * sizeof(monero::hash) + encoded_.capacity() * sizeof(text);
+  }
+
+  /*! Encode text for `ids` not already cached, in one batch. At most
+      `capacity()` ids are used. */
+  void prefill(span<const monero::hash> ids) noexcept;
+
+  //! \return z85 text of `id`, encoded now if not cached. Valid until the next call.
+  const text& get(const monero::hash& id) noexcept;
+};
+
+#endif // MOTRIX_Z85_CACHE_HPP
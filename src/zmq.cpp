@@ -30,11 +30,13 @@
 
 #include <cassert>
 #include <cerrno>
-#include <limits>
+#include <stdexcept>
 #include <utility>
 
 #include "byte_stream.hpp"
-#include "engine.hpp"
+#include "error.hpp"
+#include "reactor.hpp"
+#include "stats.hpp"
 
 namespace zmq
 {
@@ -89,6 +91,13 @@ namespace zmq
         }
     }
 
+    void close::call(void* ptr) noexcept
+    {
+        assert(ptr != nullptr); // see header
+        reactor::forget(ptr);
+        zmq_close(ptr);
+    }
+
     socket connect(void* ctx, int type, const char* address)
     {
       socket out{zmq_socket(ctx, type)};
@@ -144,43 +153,104 @@ namespace zmq
             }
         };
 
-        struct do_receive
+        /*! Moves a received `zmq_msg_t` into `byte_slice` storage, so that
+            the payload is never copied. ZMQ reference counts the buffer of
+            "large" messages internally, which makes destruction from any
+            thread safe. */
+        struct message_slice final : byte_slice_data
         {
-            /* ZMQ documentation states that message parts are atomic - either
-               all are received or none are. Looking through ZMQ code and
-               Github discussions indicates that after part 1 is returned,
-               `EAGAIN` cannot be returned to meet these guarantees. Unit tests
-               verify (for the `inproc://` case) that this is the behavior. 
-               Therefore, read errors after the first part are treated as a
-               failure for the entire message (probably `ETERM`). */
-            int operator()(byte_stream& payload, void* const socket, const int flags) const
+            message_slice() noexcept
+              : byte_slice_data(), handle_()
             {
-                static constexpr const int max_out = std::numeric_limits<int>::max();
-                const byte_slice::size_type initial = payload.size();
-                message part{};
-                for (;;)
-                {
-                    int last = 0;
-                    if ((last = zmq_msg_recv(part.handle(), socket, flags)) < 0)
-                        return last;
+                zmq_msg_init(handle());
+            }
 
-                    payload.write(part.data(), part.size());
-                    if (!zmq_msg_more(part.handle()))
-                        break;
-                }
-                const byte_slice::size_type added = payload.size() - initial;
-                return unsigned(max_out) < added ? max_out : int(added);
+            virtual ~message_slice() noexcept final override
+            {
+                zmq_msg_close(handle());
             }
+
+            zmq_msg_t* handle() noexcept
+            {
+                return std::addressof(handle_);
+            }
+
+        private:
+            zmq_msg_t handle_;
         };
+
+        stats::counter messages_adopted{"zmq.receive.messages_adopted"};
+        stats::counter bytes_adopted{"zmq.receive.bytes_adopted"};
+        stats::counter messages_copied{"zmq.receive.messages_copied"};
+        stats::counter bytes_copied{"zmq.receive.bytes_copied"};
+
+        //! \return `part` as a slice, without copying the payload. \post `part` is empty.
+        byte_slice adopt(message& part)
+        {
+            const std::size_t size = part.size();
+            if (!size)
+                return byte_slice{};
+
+            auto storage = allocate_slice<message_slice>(0);
+            if (zmq_msg_move(storage->handle(), part.handle()) != 0)
+                MOT_ZMQ_THROW("zmq_msg_move failed");
+
+            const span<const std::uint8_t> bytes{
+                static_cast<const std::uint8_t*>(zmq_msg_data(storage->handle())), size
+            };
+
+            messages_adopted.increment();
+            bytes_adopted.add(size);
+            return byte_slice{std::move(storage), bytes};
+        }
     } // anonymous
 
+    /* ZMQ documentation states that message parts are atomic - either all are
+       received or none are. Looking through ZMQ code and Github discussions
+       indicates that after part 1 is returned, `EAGAIN` cannot be returned to
+       meet these guarantees. Unit tests verify (for the `inproc://` case) that
+       this is the behavior. Therefore, read errors after the first part are
+       treated as a failure for the entire message (probably `ETERM`). */
+
     expect<byte_slice> receive(void* const socket, const int flags)
     {
-        byte_stream payload{};
-        MOT_CHECK(retry_op(do_receive{}, payload, socket, flags));
+        message part{};
+        MOT_CHECK(retry_op(zmq_msg_recv, part.handle(), socket, flags));
+        if (!zmq_msg_more(part.handle()))
+            return adopt(part);
+
+        // multipart messages are coalesced into one contiguous buffer. Parts
+        // are typically similar in size, so the first is a reasonable hint.
+        basic_byte_stream<hinted_growth> payload{part.size()};
+        for (;;)
+        {
+            payload.write(part.data(), part.size());
+            if (!zmq_msg_more(part.handle()))
+                break;
+            MOT_CHECK(retry_op(zmq_msg_recv, part.handle(), socket, flags));
+        }
+
+        if (!payload.size())
+            return byte_slice{};
+
+        messages_copied.increment();
+        bytes_copied.add(payload.size());
         return {byte_slice{std::move(payload)}};
     }
 
+    expect<byte_rope> receive_segments(void* const socket, const int flags)
+    {
+        byte_rope payload{};
+        message part{};
+        for (bool more = true; more; )
+        {
+            MOT_CHECK(retry_op(zmq_msg_recv, part.handle(), socket, flags));
+            more = zmq_msg_more(part.handle()); // `adopt` clears `part`
+            payload.push_back(adopt(part));
+        }
+        return {std::move(payload)};
+    }
+
     expect<void> send(const span<const std::uint8_t> payload, void* const socket, const int flags) noexcept
     {
         return retry_op(zmq_send, socket, payload.data(), payload.size(), flags);
@@ -204,11 +274,29 @@ namespace zmq
 
     expect<void> wait_for(void* sock)
     {
-        zmq_pollitem_t items[2] = {{sock, 0, ZMQ_POLLIN}, {NULL, engine::exit_fd(), ZMQ_POLLIN}};
-	MOT_CHECK(retry_op(zmq_poll, items, 2, -1));
-	if (items[1].revents & ZMQ_POLLIN)
-	    return make_error_code(ETERM);
-	return success();
+        return wait_for(sock, std::chrono::steady_clock::time_point::max());
+    }
+
+    expect<void> wait_for(void* sock, const std::chrono::steady_clock::time_point deadline)
+    {
+        reactor* const events = reactor::instance();
+        if (!events)
+            throw std::logic_error{"zmq::wait_for requires a reactor"};
+
+        void* const sockets[] = {sock};
+        for (;;)
+        {
+            const expect<reactor::events> ready = events->wait(sockets, deadline);
+            if (!ready)
+                return ready.error();
+            if (ready->exit)
+                return make_error_code(ETERM);
+            if (ready->readable)
+                return success();
+            if (ready->timeout)
+                return {common_error::kTimedOut};
+            // SIGWINCH is left for the display loop (`events::resize` is sticky)
+        }
     }
 } // zmq
 
@@ -28,11 +28,13 @@
 #ifndef MOTRIX_ZMQ_HPP
 #define MOTRIX_ZMQ_HPP
 
+#include <chrono>
 #include <memory>
 #include <system_error>
 #include <zmq.h>
 #include <iostream>
 
+#include "byte_rope.hpp"
 #include "byte_slice.hpp"
 #include "expect.hpp"
 #include "span.hpp"
@@ -78,13 +80,15 @@ namespace zmq
         }
     };
 
-    //! Calls `zmq_close`
-    struct close
+    //! Removes socket from `reactor` (if any), then calls `zmq_close`
+    class close
     {
+        static void call(void* ptr) noexcept;
+    public:
         void operator()(void* ptr) const noexcept
         {
             if (ptr)
-                zmq_close(ptr);
+                call(ptr);
         }
     };
 
@@ -111,11 +115,22 @@ namespace zmq
             then `net::zmq::make_error_code(EAGAIN)` will be returned if this
             would block.
 
+        \note Single part messages are adopted by the returned slice without
+            a copy. Multipart messages are copied into one buffer.
+
         \param socket Handle created with `zmq_socket`.
         \param flags See `zmq_msg_read` for possible flags.
      	\return Message payload read from `socket` or ZMQ error. */
     expect<byte_slice> receive(void* socket, int flags = 0);
 
+    /*! Same as `receive` except every part is adopted without a copy, and
+        stored as a separate segment in the returned rope.
+
+        \param socket Handle created with `zmq_socket`.
+        \param flags See `zmq_msg_read` for possible flags.
+        \return Message parts read from `socket` or ZMQ error. */
+    expect<byte_rope> receive_segments(void* socket, int flags = 0);
+
     /*! Sends `payload` on `socket`. Blocks until the entire message is queued
         for sending, or until `zmq_term` is called on the `zmq_context`
         associated with `socket`. If the context is terminated,
@@ -135,8 +150,20 @@ namespace zmq
 
     expect<void> send(byte_slice&& payload, void* socket, int flags = 0) noexcept;
 
+    /*! Wait until `sock` is readable, using `reactor::instance()`.
+
+        \throw std::logic_error if no `reactor` exists.
+        \return `ETERM` if SIGINT/SIGTERM was received, or `success()`. */
     expect<void> wait_for(void* sock);
 
+    /*! Wait until `sock` is readable, or `deadline` is reached, using
+        `reactor::instance()`.
+
+        \throw std::logic_error if no `reactor` exists.
+        \return `common_error::kTimedOut` if `deadline` is reached, `ETERM` if
+            SIGINT/SIGTERM was received, or `success()` if readable. */
+    expect<void> wait_for(void* sock, std::chrono::steady_clock::time_point deadline);
+
     template<typename F, typename... T>
     expect<void> retry_op(F op, T&&... args) noexcept(noexcept(op(args...)))
     {
@@ -0,0 +1,127 @@
+// Copyright (c) 2020, Lee Clagett
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/* Checks `hash_set` against `std::set`, and that a moved-from set is empty
+   and still usable (the engine re-uses one for every txpool sync). */
+
+#include "hash_set.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <set>
+#include <utility>
+
+namespace
+{
+  constexpr const unsigned random_rounds = 200000;
+
+  std::mt19937 generator{0x6d6f7472};
+  unsigned failures = 0;
+
+  void check(const bool result, const char* what)
+  {
+    if (!result && ++failures <= 20)
+      std::cerr << "FAIL: " << what << std::endl;
+  }
+
+  //! \return Hash from a small range of values, so inserts and erases collide.
+  monero::hash small_hash(const unsigned value)
+  {
+    monero::hash out{};
+    out.data[0] = std::uint8_t(value);
+    out.data[31] = std::uint8_t(value >> 8);
+    return out;
+  }
+
+  //! Compare size, contents and lookups of `actual` with `expected`.
+  void check_same(const hash_set& actual, const std::set<monero::hash>& expected, const char* what)
+  {
+    check(actual.size() == expected.size(), what);
+    check(std::set<monero::hash>(actual.begin(), actual.end()) == expected, what);
+    for (const monero::hash& key : expected)
+      check(actual.contains(key), what);
+  }
+
+  void test_random()
+  {
+    hash_set actual{};
+    std::set<monero::hash> expected{};
+    std::uniform_int_distribution<unsigned> values{0, 2000};
+    std::uniform_int_distribution<unsigned> operation{0, 9};
+    for (unsigned round = 0; round < random_rounds; ++round)
+    {
+      const monero::hash key = small_hash(values(generator));
+      const unsigned op = operation(generator);
+      if (op < 6)
+        check(actual.insert(key) == expected.insert(key).second, "insert result");
+      else if (op < 9)
+        check(actual.erase(key) == expected.erase(key), "erase result");
+      else
+        check(actual.contains(key) == bool(expected.count(key)), "contains result");
+    }
+    check_same(actual, expected, "random operations");
+
+    actual.clear();
+    check(actual.empty() && !actual.contains(small_hash(1)), "clear");
+  }
+
+  void test_move()
+  {
+    hash_set source{};
+    std::set<monero::hash> expected{};
+    for (unsigned i = 0; i < 100; ++i)
+    {
+      source.insert(small_hash(i));
+      expected.insert(small_hash(i));
+    }
+
+    hash_set constructed{std::move(source)};
+    check_same(constructed, expected, "move constructed");
+    check(source.empty() && source.size() == 0 && source.begin() == source.end(), "moved-from (construct) is empty");
+    check(!source.contains(small_hash(1)) && source.erase(small_hash(1)) == 0, "moved-from (construct) lookups");
+    check(source.insert(small_hash(5000)) && source.contains(small_hash(5000)) && source.size() == 1, "moved-from (construct) insert");
+
+    hash_set assigned{};
+    assigned.insert(small_hash(7000));
+    assigned = std::move(constructed);
+    check_same(assigned, expected, "move assigned");
+    check(constructed.empty() && constructed.memory_usage() == 0, "moved-from (assign) is empty");
+    for (unsigned i = 0; i < 100; ++i)
+      check(constructed.insert(small_hash(i + 3000)), "moved-from (assign) insert");
+    check(constructed.size() == 100 && constructed.contains(small_hash(3050)), "moved-from (assign) rehash");
+  }
+}
+
+int main()
+{
+  test_random();
+  test_move();
+  std::cout << "hash_set: " << (failures ? "FAIL" : "PASS") << std::endl;
+  return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,186 @@
+// Copyright (c) 2020, The Monero Project
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/* Compares every SIMD hex kernel against the scalar kernel. The kernels are
+   internal to `hex.cpp`, so that file is compiled into this test directly. */
+
+#include "../src/hex.cpp"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace
+{
+  constexpr const std::size_t max_bytes = 300;
+  constexpr const std::size_t exhaustive_bytes = 72; //!< Several AVX2 blocks, plus every tail length
+  constexpr const unsigned random_rounds = 20000;
+  constexpr const unsigned char guard = 0xA5;
+
+  struct kernel
+  {
+    const char* name;
+    hex_kernels functions;
+  };
+
+  std::mt19937 generator{0x6d6f7472};
+  unsigned failures = 0;
+
+  void fail(const kernel& tested, const char* what, const std::size_t length, const std::size_t position)
+  {
+    if (++failures <= 20)
+      std::cerr << tested.name << ": " << what << " length=" << length << " position=" << position << std::endl;
+  }
+
+  //! Compare output and guard bytes of `tested` encode with `encode_scalar`.
+  void check_encode(const kernel& tested, const std::vector<std::uint8_t>& src, const std::size_t position)
+  {
+    std::vector<char> expected(src.size() * 2 + 1, char(guard));
+    std::vector<char> actual(src.size() * 2 + 1, char(guard));
+    encode_scalar(expected.data(), src.data(), src.size());
+    tested.functions.encode(actual.data(), src.data(), src.size());
+    if (expected != actual)
+      fail(tested, "encode mismatch", src.size(), position);
+  }
+
+  //! Compare result, output and guard bytes of `tested` decode with `decode_scalar`.
+  void check_decode(const kernel& tested, const std::vector<unsigned char>& src, const std::size_t position)
+  {
+    std::vector<std::uint8_t> expected(src.size() / 2 + 1, guard);
+    std::vector<std::uint8_t> actual(src.size() / 2 + 1, guard);
+    const bool expected_valid = decode_scalar(expected.data(), src.data(), src.size());
+    const bool actual_valid = tested.functions.decode(actual.data(), src.data(), src.size());
+    if (expected_valid != actual_valid)
+      fail(tested, "decode result mismatch", src.size(), position);
+    else if (actual.back() != guard)
+      fail(tested, "decode wrote past output", src.size(), position);
+    else if (expected_valid && expected != actual)
+      fail(tested, "decode mismatch", src.size(), position);
+  }
+
+  std::vector<unsigned char> encode(const std::vector<std::uint8_t>& src)
+  {
+    std::vector<char> out(src.size() * 2);
+    encode_scalar(out.data(), src.data(), src.size());
+    return {out.begin(), out.end()};
+  }
+
+  std::vector<std::uint8_t> random_bytes(const std::size_t length)
+  {
+    std::uniform_int_distribution<unsigned> byte{0, 255};
+    std::vector<std::uint8_t> out(length);
+    for (std::uint8_t& value : out)
+      value = byte(generator);
+    return out;
+  }
+
+  void test(const kernel& tested)
+  {
+    // every byte value, and every character value, at every position
+    for (std::size_t length = 1; length <= exhaustive_bytes; ++length)
+    {
+      std::vector<std::uint8_t> bytes = random_bytes(length);
+      for (std::size_t position = 0; position < length; ++position)
+      {
+        const std::uint8_t original = bytes[position];
+        for (unsigned value = 0; value < 256; ++value)
+        {
+          bytes[position] = value;
+          check_encode(tested, bytes, position);
+        }
+        bytes[position] = original;
+      }
+
+      std::vector<unsigned char> chars = encode(bytes);
+      for (std::size_t position = 0; position < chars.size(); ++position)
+      {
+        const unsigned char original = chars[position];
+        for (unsigned value = 0; value < 256; ++value)
+        {
+          chars[position] = value;
+          check_decode(tested, chars, position);
+        }
+        chars[position] = original;
+      }
+    }
+
+    // random lengths and contents, with upper case and invalid characters
+    std::uniform_int_distribution<std::size_t> lengths{0, max_bytes};
+    std::uniform_int_distribution<unsigned> byte{0, 255};
+    for (unsigned round = 0; round < random_rounds; ++round)
+    {
+      const std::vector<std::uint8_t> bytes = random_bytes(lengths(generator));
+      check_encode(tested, bytes, 0);
+
+      std::vector<unsigned char> chars = encode(bytes);
+      for (unsigned char& value : chars)
+      {
+        if (byte(generator) < 64)
+          value = std::toupper(value);
+      }
+      check_decode(tested, chars, 0);
+
+      if (!chars.empty())
+      {
+        std::uniform_int_distribution<std::size_t> positions{0, chars.size() - 1};
+        const std::size_t position = positions(generator);
+        chars[position] = byte(generator);
+        check_decode(tested, chars, position);
+      }
+    }
+  }
+}
+
+int main()
+{
+  std::vector<kernel> kernels{};
+#ifdef MOTRIX_HEX_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse2"))
+    kernels.push_back({"sse2", {encode_sse2, decode_sse2}});
+  if (__builtin_cpu_supports("avx2"))
+    kernels.push_back({"avx2", {encode_avx2, decode_avx2}});
+#endif
+
+  if (kernels.empty())
+  {
+    std::cout << "No SIMD hex kernels for this CPU" << std::endl;
+    return 77; // automake skip
+  }
+
+  for (const kernel& tested : kernels)
+  {
+    const unsigned previous = failures;
+    test(tested);
+    std::cout << tested.name << ": " << (failures != previous ? "FAIL" : "PASS") << std::endl;
+  }
+  return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}